@@ -0,0 +1,834 @@
+#include "alloc_counter.h"
+#include "bench_utils.h"
+#include "AHP.h"
+#include "ANP.h"
+#include "Diagnostics.h"
+#include "Fuzzy.h"
+#include "Hierarchy.h"
+#include "QuestionSelector.h"
+#include "RandomIndex.h"
+#include "Sensitivity.h"
+#include "Uncertainty.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+// Sweeps the AHP computation core (matrix building, group aggregation, ranking)
+// and prints one JSON record per case. Usage: ahp_bench [--quick] [--out FILE]
+// Exits with a non-zero code if a steady-state workspace ranking performed any heap allocation.
+// AHP_THREADS sets the size of the worker pool, e.g. AHP_THREADS=1 for a sequential baseline.
+
+namespace
+{
+  constexpr std::array<double, 17> kSaatyScale = {
+    1.0/9, 1.0/8, 1.0/7, 1.0/6, 1.0/5, 1.0/4, 1.0/3, 1.0/2, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0
+  };
+
+  AHP::Matrix2D randomReciprocalMatrix(size_t n, std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> pick(0, kSaatyScale.size() - 1);
+    AHP::Matrix2D matrix = AHP::Matrix2D::Ones(n, n);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = i + 1; j < n; j++) {
+        const double value = kSaatyScale[pick(rng)];
+        matrix(i, j) = value;
+        matrix(j, i) = 1.0 / value;
+      }
+    }
+    return matrix;
+  }
+
+  // Judgements implied by random priorities with log-normal noise, as a fairly consistent panel would produce
+  AHP::Matrix2D nearConsistentMatrix(size_t n, double sigma, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> priority(1.0, 9.0);
+    std::normal_distribution<double> noise(0.0, sigma);
+    Eigen::VectorXd w(n);
+    for (size_t i = 0; i < n; i++) {
+      w(i) = priority(rng);
+    }
+
+    AHP::Matrix2D matrix = AHP::Matrix2D::Ones(n, n);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = i + 1; j < n; j++) {
+        matrix(i, j) = w(i) / w(j) * std::exp(noise(rng));
+        matrix(j, i) = 1.0 / matrix(i, j);
+      }
+    }
+    return matrix;
+  }
+
+  // Multiplies every judgement by log-normal noise, the way one more submission nudges the aggregate of a few dozen
+  AHP::Matrix2D perturbed(const AHP::Matrix2D& matrix, double sigma, std::mt19937_64& rng) {
+    std::normal_distribution<double> noise(0.0, sigma);
+    AHP::Matrix2D result = matrix;
+    for (Eigen::Index i = 0; i < matrix.rows(); i++) {
+      for (Eigen::Index j = i + 1; j < matrix.cols(); j++) {
+        result(i, j) *= std::exp(noise(rng));
+        result(j, i) = 1.0 / result(i, j);
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::string> names(const std::string& prefix, size_t count) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; i++) {
+      result.push_back(prefix + std::to_string(i));
+    }
+    return result;
+  }
+
+  bench::Record baseRecord(const std::string& kernel, size_t agents, size_t criteria, size_t alternatives,
+                           double cells, const bench::Measurement& m) {
+    bench::Record record;
+    record.add("kernel", kernel)
+      .add("agents", agents)
+      .add("criteria", criteria)
+      .add("alternatives", alternatives)
+      .add("iterations", m.iterations)
+      .add("ns_per_op", m.nsPerOp)
+      .add("best_ns_per_op", m.bestNs)
+      .add("ns_per_cell", m.nsPerOp / cells)
+      .add("cells_per_second", cells * 1e9 / m.nsPerOp)
+      .add("ops_per_second", 1e9 / m.nsPerOp)
+      .add("peak_rss_kb", bench::peakRssKb())
+      .add("threads", parallel::threadCount());
+    return record;
+  }
+
+  bench::Record benchBuildMatrix(size_t n, std::mt19937_64& rng) {
+    const auto alternatives = names("alt", n);
+    const AHP::Matrix2D source = randomReciprocalMatrix(n, rng);
+
+    AHP::Comparisons comparisons;
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        comparisons[alternatives[i]][alternatives[j]] = source(i, j);
+      }
+    }
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(AHP::buildMatrix(comparisons, alternatives));
+    });
+    return baseRecord("buildMatrix", 1, 0, n, static_cast<double>(n * n), m);
+  }
+
+  AHP::AHPMeanCalculator makeMeanCalculator(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    const auto criteriaNames = names("crit", criteria);
+    AHP::AHPMeanCalculator meanCalc(criteriaNames);
+
+    for (size_t agent = 0; agent < agents; agent++) {
+      std::map<std::string, AHP::Matrix2D> altMatrices;
+      for (auto& criterion : criteriaNames) {
+        altMatrices[criterion] = randomReciprocalMatrix(alternatives, rng);
+      }
+      meanCalc.addAgent(randomReciprocalMatrix(criteria, rng), std::move(altMatrices));
+    }
+    return meanCalc;
+  }
+
+  // Reading the aggregate; the log sums are maintained on insertion, so the cost does not depend on the agent count
+  bench::Record benchMean(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(meanCalc.getMeanCritMatrix());
+      bench::doNotOptimize(meanCalc.getMeanAltMatrices());
+    });
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPMeanCalculator", agents, criteria, alternatives, cells, m);
+  }
+
+  // One expert weight change, O(criteria * n^2) whatever the number of agents
+  bench::Record benchSetWeight(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+
+    std::uniform_int_distribution<size_t> pickAgent(0, agents - 1);
+    double weight = 1.0;
+    auto m = bench::measure([&] {
+      weight = weight == 1.0 ? 2.0 : 1.0;
+      meanCalc.setWeight(pickAgent(rng), weight);
+    });
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPMeanCalculator/setWeight", agents, criteria, alternatives, cells, m);
+  }
+
+  // Consensus read from the running log moments, O(criteria * n^2) whatever the number of agents
+  bench::Record benchConsensus(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(meanCalc.consensus());
+    });
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPMeanCalculator/consensus", agents, criteria, alternatives, cells, m);
+  }
+
+  // AIP with every individual ranking cached: one weighted mean over agents x alternatives
+  bench::Record benchIndividualPriorities(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+    meanCalc.getAggregatedPriorities(AHP::PriorityMethod::GeometricMean, AHP::AggregationMode::GeometricPriorities);
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(meanCalc.getAggregatedPriorities(AHP::PriorityMethod::GeometricMean,
+                                                            AHP::AggregationMode::GeometricPriorities));
+    });
+    return baseRecord("AHPMeanCalculator/aip", agents, criteria, alternatives, static_cast<double>(agents * alternatives), m);
+  }
+
+  // AIP after each new submission: only the new agent is ranked, whatever the number of agents before it
+  bench::Record benchIndividualSubmit(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+    meanCalc.getAggregatedPriorities(AHP::PriorityMethod::GeometricMean, AHP::AggregationMode::GeometricPriorities);
+
+    const auto criteriaNames = meanCalc.getCriteria();
+    const AHP::Matrix2D critMatrix = randomReciprocalMatrix(criteria, rng);
+    std::map<std::string, AHP::Matrix2D> altMatrices;
+    for (auto& criterion : criteriaNames) {
+      altMatrices[criterion] = randomReciprocalMatrix(alternatives, rng);
+    }
+
+    auto m = bench::measure([&] {
+      meanCalc.addAgent(AHP::Matrix2D(critMatrix), std::map<std::string, AHP::Matrix2D>(altMatrices));
+      bench::doNotOptimize(meanCalc.getAggregatedPriorities(AHP::PriorityMethod::GeometricMean,
+                                                            AHP::AggregationMode::GeometricPriorities));
+    });
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPMeanCalculator/aip-submit", agents, criteria, alternatives, cells, m);
+  }
+
+  // Leave-one-out over every agent by downdating the log sums; cells counts one downdated survey per agent
+  bench::Record benchLeaveOneOut(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(meanCalc.leaveOneOut(AHP::PriorityMethod::GeometricMean));
+    });
+    const double cells = static_cast<double>(agents * (criteria * criteria + criteria * alternatives * alternatives));
+    return baseRecord("AHPMeanCalculator/leaveOneOut", agents, criteria, alternatives, cells, m);
+  }
+
+  // 1000 bootstrap resamples; cells counts the log cells of every agent in every resample
+  bench::Record benchBootstrap(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    constexpr size_t Resamples = 1000;
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(meanCalc.bootstrap(AHP::PriorityMethod::GeometricMean, Resamples));
+    });
+    const double cells = static_cast<double>(Resamples * agents * (criteria * criteria + criteria * alternatives * alternatives));
+    return baseRecord("AHPMeanCalculator/bootstrap", agents, criteria, alternatives, cells, m);
+  }
+
+  bench::Record benchRanking(size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    const AHP::Matrix2D critMatrix = randomReciprocalMatrix(criteria, rng);
+    std::vector<AHP::Matrix2D> altMatrices;
+    for (size_t i = 0; i < criteria; i++) {
+      altMatrices.push_back(randomReciprocalMatrix(alternatives, rng));
+    }
+
+    AHP::AHPRanker ranker;
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(ranker.calculateRanking(critMatrix, altMatrices));
+    });
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPRanker", 1, criteria, alternatives, cells, m);
+  }
+
+  // Caller-owned workspace path; after the first call no ranking may touch the heap
+  bench::Record benchRankingWorkspace(size_t criteria, size_t alternatives, std::mt19937_64& rng, bool& allocationFree) {
+    const AHP::Matrix2D critMatrix = randomReciprocalMatrix(criteria, rng);
+    std::vector<AHP::Matrix2D> altMatrices;
+    for (size_t i = 0; i < criteria; i++) {
+      altMatrices.push_back(randomReciprocalMatrix(alternatives, rng));
+    }
+
+    AHP::AHPRanker ranker;
+    AHP::RankingWorkspace ws;
+    ranker.calculateRanking(critMatrix, altMatrices, ws);
+
+    const auto allocsBefore = bench::allocationCount();
+    auto m = bench::measure([&] {
+      ranker.calculateRanking(critMatrix, altMatrices, ws);
+      bench::doNotOptimize(ws.ranking.data());
+    });
+    const auto allocations = bench::allocationCount() - allocsBefore;
+    allocationFree = allocationFree && allocations == 0;
+
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("AHPRanker/workspace", 1, criteria, alternatives, cells, m)
+      .add("allocations_per_op", static_cast<double>(allocations) / (m.iterations + 1))
+      .add("ns_per_matrix", m.nsPerOp / (criteria + 1));
+  }
+
+  // What /results does for a complete survey, reading the aggregate and ranking it in a kept workspace, with span
+  // recording off and on. ns_per_op is the traced time, tracing_overhead is traced over untraced median time.
+  bench::Record benchTracingOverhead(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    AHP::AHPMeanCalculator meanCalc = makeMeanCalculator(agents, criteria, alternatives, rng);
+    AHP::AHPRanker ranker;
+    AHP::RankingWorkspace ws;
+    auto results = [&] {
+      ranker.calculateRanking(meanCalc.getMeanCritMatrix(), meanCalc.getMeanAltMatrices(), ws);
+      bench::doNotOptimize(ws.ranking.data());
+    };
+
+    // Traced and untraced ops alternate, so drift in machine speed hits both sides alike, and the overhead is the
+    // ratio of the medians, which interrupts on a shared box do not move
+    results();
+    std::vector<double> off, on;
+    tracing::clear();
+    for (double totalNs = 0.0; off.size() < 3 || totalNs < 0.4e9;) {
+      for (bool enabled : {false, true}) {
+        tracing::setEnabled(enabled);
+        const auto start = bench::Clock::now();
+        results();
+        const double ns = std::chrono::duration<double, std::nano>(bench::Clock::now() - start).count();
+        (enabled ? on : off).push_back(ns);
+        totalNs += ns;
+      }
+    }
+    tracing::setEnabled(false);
+    const bench::Measurement untraced = bench::summarize(off);
+    const bench::Measurement traced = bench::summarize(on);
+
+    // spans recorded per op, to show none were dropped at the per-thread cap
+    const std::string trace = tracing::renderChromeTrace();
+    tracing::clear();
+    size_t spans = 0;
+    for (size_t at = trace.find("\"ph\":\"X\""); at != std::string::npos; at = trace.find("\"ph\":\"X\"", at + 1)) {
+      spans++;
+    }
+
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord("results/tracing", agents, criteria, alternatives, cells, traced)
+      .add("untraced_ns_per_op", untraced.nsPerOp)
+      .add("untraced_median_ns", untraced.medianNs)
+      .add("traced_median_ns", traced.medianNs)
+      .add("tracing_overhead", traced.medianNs / untraced.medianNs)
+      .add("spans_per_op", static_cast<double>(spans) / on.size());
+  }
+
+  // Same data through every priority method
+  bench::Record benchPriorityMethod(AHP::PriorityMethod method, const char* name, size_t criteria, size_t alternatives,
+                                    std::mt19937_64& rng) {
+    const AHP::Matrix2D critMatrix = nearConsistentMatrix(criteria, 0.3, rng);
+    std::vector<AHP::Matrix2D> altMatrices;
+    for (size_t i = 0; i < criteria; i++) {
+      altMatrices.push_back(nearConsistentMatrix(alternatives, 0.3, rng));
+    }
+
+    AHP::AHPRanker ranker(method);
+    AHP::RankingWorkspace ws;
+    auto m = bench::measure([&] {
+      ws.hasWeights = false;   // no warm start, every method sees the data for the first time
+      ranker.calculateRanking(critMatrix, altMatrices, ws);
+      bench::doNotOptimize(ws.ranking.data());
+    });
+
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord(std::string("AHPRanker/") + name, 1, criteria, alternatives, cells, m);
+  }
+
+  // One matrix's policy kernel alone, through the fixed-size and the dynamic path, to place each policy's maxFixedSize
+  // where the fixed path stops winning. ns_per_op times the fixed path, fixed_speedup is dynamic over fixed time.
+  bench::Record benchKernelPath(AHP::PriorityMethod method, const char* name, size_t n, std::mt19937_64& rng) {
+    const AHP::Matrix2D matrix = nearConsistentMatrix(n, 0.3, rng);
+    Eigen::VectorXd weights(n), products(n);
+    auto time = [&](bool fixedSize) {
+      return bench::measure([&] {
+        bench::doNotOptimize(AHP::kernelLambdaMax(matrix, method, fixedSize, weights, products));
+      });
+    };
+    const bench::Measurement fixed = time(true);
+    const bench::Measurement dynamic = time(false);
+    return baseRecord(std::string("kernel/") + name, 1, 0, n, static_cast<double>(n * n), fixed)
+      .add("dynamic_ns_per_op", dynamic.nsPerOp)
+      .add("fixed_speedup", dynamic.nsPerOp / fixed.nsPerOp);
+  }
+
+  // Rank reversal thresholds of every criterion over all pairs of alternatives; cells counts criterion-pair thresholds
+  bench::Record benchSensitivity(size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> uniform(0.1, 1.0);
+    Eigen::VectorXd criteriaWeights = Eigen::VectorXd::NullaryExpr(criteria, [&] { return uniform(rng); });
+    criteriaWeights /= criteriaWeights.sum();
+    AHP::Matrix2D localWeights = AHP::Matrix2D::NullaryExpr(alternatives, criteria, [&] { return uniform(rng); });
+    localWeights.array().rowwise() /= localWeights.colwise().sum().array();
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(AHP::criteriaSensitivity(criteriaWeights, localWeights));
+    });
+    const double cells = static_cast<double>(criteria * alternatives * (alternatives - 1) / 2);
+    return baseRecord("criteriaSensitivity", 1, criteria, alternatives, cells, m);
+  }
+
+  // A /whatif slider move: reweighting cached local weights is one matrix-vector product
+  bench::Record benchWhatIf(size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> uniform(0.1, 1.0);
+    Eigen::VectorXd criteriaWeights = Eigen::VectorXd::NullaryExpr(criteria, [&] { return uniform(rng); });
+    criteriaWeights /= criteriaWeights.sum();
+    AHP::Matrix2D localWeights = AHP::Matrix2D::NullaryExpr(alternatives, criteria, [&] { return uniform(rng); });
+    localWeights.array().rowwise() /= localWeights.colwise().sum().array();
+    Eigen::VectorXd ranking(alternatives);
+
+    auto m = bench::measure([&] {
+      ranking.noalias() = localWeights * criteriaWeights;
+      bench::doNotOptimize(ranking);
+    });
+    return baseRecord("whatIf/reweight", 1, criteria, alternatives, static_cast<double>(criteria * alternatives), m);
+  }
+
+  // Criteria tree with `branching[d]` sub-criteria per node at depth d. "full" recomputes every subtree, "path"
+  // changes the local weights of one deepest inner node and recomputes its path to the goal; cells are leaves.
+  bench::Record benchHierarchy(const std::vector<size_t>& branching, bool path, std::mt19937_64& rng) {
+    std::vector<std::string> top;
+    std::map<std::string, std::vector<std::string>> children;
+    std::vector<std::string> level;
+    size_t named = 0;
+    for (size_t d = 0; d < branching.size(); d++) {
+      std::vector<std::string> next;
+      for (size_t p = 0; p < std::max<size_t>(level.size(), 1); p++) {
+        for (size_t c = 0; c < branching[d]; c++) {
+          next.push_back(std::to_string(named++));
+          (d == 0 ? top : children[level[p]]).push_back(next.back());
+        }
+      }
+      level = std::move(next);
+    }
+    AHP::CriteriaHierarchy hierarchy(top, children);
+    std::uniform_real_distribution<double> uniform(0.1, 1.0);
+    std::vector<Eigen::VectorXd> local;
+    for (Eigen::Index node : hierarchy.innerNodes()) {
+      local.push_back(Eigen::VectorXd::NullaryExpr(hierarchy.childCount(node), [&] { return uniform(rng); }));
+      local.back() /= local.back().sum();
+      hierarchy.setLocalWeights(node, local.back());
+    }
+    bench::doNotOptimize(hierarchy.globalWeights());
+
+    const Eigen::Index deepest = hierarchy.innerNodes().back();
+    auto m = bench::measure([&] {
+      if (path) {
+        hierarchy.setLocalWeights(deepest, local.back());
+      } else {
+        for (size_t k = 0; k < local.size(); k++) {
+          hierarchy.setLocalWeights(hierarchy.innerNodes()[k], local[k]);
+        }
+      }
+      bench::doNotOptimize(hierarchy.globalWeights());
+    });
+    const size_t leaves = hierarchy.leaves().size();
+    return baseRecord(path ? "CriteriaHierarchy/path" : "CriteriaHierarchy/full", 1, leaves, 0, static_cast<double>(leaves), m)
+      .add("depth", static_cast<double>(branching.size()))
+      .add("recomputed_nodes", static_cast<double>(hierarchy.recomputedNodes()));
+  }
+
+  // ANP network of `clusters` x `perCluster` nodes, each depending on all nodes of its own and the next
+  // `dependencies` - 1 clusters. Records the supermatrix build (cells: judgement cells) and the limit (cells: nonzeros
+  // per iteration).
+  std::vector<bench::Record> benchNetwork(size_t clusters, size_t perCluster, size_t dependencies, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> uniform(1.0, 9.0);
+    AHP::NetworkModel model;
+    for (size_t c = 0; c <= clusters; c++) {
+      model.clusterBegin.push_back(static_cast<Eigen::Index>(c * perCluster));
+    }
+    for (size_t c = 0; c < clusters; c++) {
+      model.clusters.push_back(std::to_string(c));
+      for (size_t k = 0; k < perCluster; k++) {
+        model.nodes.push_back(std::to_string(c * perCluster + k));
+      }
+    }
+    double cells = 0.0;
+    for (size_t j = 0; j < model.nodes.size(); j++) {
+      const size_t own = j / perCluster;
+      for (size_t d = 0; d < dependencies; d++) {
+        const size_t cluster = (own + d) % clusters;
+        AHP::NetworkBlock block{static_cast<Eigen::Index>(j), {}, {}};
+        Eigen::VectorXd w(perCluster);
+        for (size_t k = 0; k < perCluster; k++) {
+          block.compared.push_back(static_cast<Eigen::Index>(cluster * perCluster + k));
+          w(k) = uniform(rng);
+        }
+        block.matrix = w * w.cwiseInverse().transpose();   // consistent, building priorities is what is measured
+        cells += static_cast<double>(block.matrix.size());
+        model.nodeBlocks.push_back(std::move(block));
+      }
+    }
+
+    const size_t n = model.nodes.size();
+    AHP::Supermatrix supermatrix;
+    auto build = bench::measure([&] {
+      supermatrix = AHP::buildSupermatrix(model, AHP::PriorityMethod::GeometricMean);
+    });
+    AHP::LimitPriorities limit;
+    auto m = bench::measure([&] {
+      limit = AHP::limitPriorities(supermatrix.weighted);
+    });
+    const double nonZeros = static_cast<double>(supermatrix.weighted.nonZeros());
+    return {
+      baseRecord("ANP/buildSupermatrix", 1, clusters, n, cells, build),
+      baseRecord("ANP/limitPriorities", 1, clusters, n, nonZeros * limit.iterations, m)
+        .add("power_iterations", static_cast<double>(limit.iterations))
+        .add("period", static_cast<double>(limit.period)),
+    };
+  }
+
+  // Triad diagnostics of one near-consistent matrix with one planted outlier, the top 5 judgements reported;
+  // cells are triads scored, n^2 / 2 judgements times the third items
+  bench::Record benchDiagnostics(size_t n, Eigen::Index samples, std::mt19937_64& rng) {
+    AHP::Matrix2D matrix = nearConsistentMatrix(n, 0.2, rng);
+    matrix(0, n - 1) *= 9.0;
+    matrix(n - 1, 0) = 1.0 / matrix(0, n - 1);
+
+    AHP::ConsistencyDiagnostics diagnostics;
+    auto m = bench::measure([&] {
+      diagnostics = AHP::diagnoseConsistency(matrix, AHP::PriorityMethod::GeometricMean, 5, samples);
+    });
+    const auto& worst = diagnostics.judgements.front();
+    const bool found = worst.i == 0 && worst.j == static_cast<Eigen::Index>(n - 1);
+    const double cells = static_cast<double>(n * (n - 1) / 2) * static_cast<double>(diagnostics.thirdItems);
+    return baseRecord(samples > 0 ? "diagnoseConsistency/sampled" : "diagnoseConsistency", 1, 0, n, cells, m)
+      .add("third_items", static_cast<double>(diagnostics.thirdItems))
+      .add("outlier_found", found ? 1.0 : 0.0);
+  }
+
+  // Fuzzy AHP next to the crisp aggregate of the same judgements: ranking (reading the aggregate and ranking it) and one
+  // expert weight change, each with its crisp counterpart's time and the ratio of the two
+  std::vector<bench::Record> benchFuzzy(size_t agents, size_t criteria, size_t alternatives, std::mt19937_64& rng) {
+    const auto criteriaNames = names("crit", criteria);
+    AHP::AHPMeanCalculator meanCalc(criteriaNames);
+    AHP::FuzzyMeanCalculator fuzzy(criteria, alternatives, 1.0);
+    for (size_t agent = 0; agent < agents; agent++) {
+      AHP::Matrix2D critMatrix = randomReciprocalMatrix(criteria, rng);
+      std::vector<AHP::Matrix2D> altMatrices;
+      std::map<std::string, AHP::Matrix2D> namedAltMatrices;
+      for (auto& criterion : criteriaNames) {
+        altMatrices.push_back(randomReciprocalMatrix(alternatives, rng));
+        namedAltMatrices[criterion] = altMatrices.back();
+      }
+      fuzzy.addAgent(critMatrix, altMatrices);
+      meanCalc.addAgent(std::move(critMatrix), std::move(namedAltMatrices));
+    }
+
+    AHP::AHPRanker ranker;
+    AHP::RankingWorkspace ws;
+    auto crisp = bench::measure([&] {
+      ranker.calculateRanking(meanCalc.getMeanCritMatrix(), meanCalc.getMeanAltMatrices(), ws);
+      bench::doNotOptimize(ws.ranking);
+    });
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(fuzzy.rank());
+    });
+
+    std::uniform_int_distribution<size_t> pickAgent(0, agents - 1);
+    double weight = 1.0;
+    auto crispWeight = bench::measure([&] {
+      weight = weight == 1.0 ? 2.0 : 1.0;
+      meanCalc.setWeight(pickAgent(rng), weight);
+    });
+    auto fuzzyWeight = bench::measure([&] {
+      weight = weight == 1.0 ? 2.0 : 1.0;
+      fuzzy.setWeight(pickAgent(rng), weight);
+    });
+
+    const double cells = static_cast<double>(3 * (criteria * criteria + criteria * alternatives * alternatives));
+    return {
+      baseRecord("FuzzyMeanCalculator/rank", agents, criteria, alternatives, cells, m)
+        .add("crisp_ns_per_op", crisp.nsPerOp)
+        .add("crisp_ratio", m.nsPerOp / crisp.nsPerOp),
+      baseRecord("FuzzyMeanCalculator/setWeight", agents, criteria, alternatives, cells, fuzzyWeight)
+        .add("crisp_ns_per_op", crispWeight.nsPerOp)
+        .add("crisp_ratio", fuzzyWeight.nsPerOp / crispWeight.nsPerOp),
+    };
+  }
+
+  // Monte Carlo judgement noise; cells counts every judgement of every simulation
+  bench::Record benchUncertainty(AHP::PriorityMethod method, const char* methodName, AHP::JudgementNoise noise,
+                                 const char* noiseName, size_t simulations, size_t criteria, size_t alternatives,
+                                 std::mt19937_64& rng) {
+    const AHP::Matrix2D critMatrix = nearConsistentMatrix(criteria, 0.3, rng);
+    std::vector<AHP::Matrix2D> altMatrices;
+    for (size_t i = 0; i < criteria; i++) {
+      altMatrices.push_back(nearConsistentMatrix(alternatives, 0.3, rng));
+    }
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(AHP::simulateJudgementUncertainty(critMatrix, altMatrices, method, noise, 0.1, simulations));
+    });
+    const double cells = static_cast<double>(simulations * (criteria * (criteria - 1) + criteria * alternatives * (alternatives - 1)) / 2);
+    return baseRecord(std::string("Uncertainty/") + methodName + "/" + noiseName, 1, criteria, alternatives, cells, m)
+      .add("simulations", static_cast<double>(simulations));
+  }
+
+  // n log2 n judgements of noisy priorities: a random spanning tree keeps the graph connected, the rest are random pairs
+  AHP::SparseComparisons sparseComparisons(size_t n, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> priority(1.0, 9.0);
+    std::normal_distribution<double> noise(0.0, 0.3);
+    Eigen::VectorXd w(n);
+    for (size_t i = 0; i < n; i++) {
+      w(i) = priority(rng);
+    }
+
+    AHP::SparseComparisons sparse;
+    sparse.n = n;
+    auto judge = [&](Eigen::Index i, Eigen::Index j) {
+      sparse.judgements.push_back({std::min(i, j), std::max(i, j), 1.0});
+      auto& judgement = sparse.judgements.back();
+      judgement.value = w(judgement.i) / w(judgement.j) * std::exp(noise(rng));
+    };
+
+    for (size_t i = 1; i < n; i++) {
+      judge(i, std::uniform_int_distribution<size_t>(0, i - 1)(rng));
+    }
+    const size_t target = static_cast<size_t>(n * std::log2(static_cast<double>(n)));
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    while (sparse.judgements.size() < target) {
+      const size_t i = pick(rng), j = pick(rng);
+      if (i != j)
+        judge(i, j);   // duplicates of a pair are rare and only weight it twice
+    }
+    return sparse;
+  }
+
+  bench::Record benchSparseWeights(size_t n, std::mt19937_64& rng) {
+    const AHP::SparseComparisons sparse = sparseComparisons(n, rng);
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(AHP::sparseLogLeastSquaresWeights(sparse));
+    });
+    return baseRecord("sparseLogLeastSquares", 1, 1, n, static_cast<double>(sparse.judgements.size()), m)
+      .add("judgements", sparse.judgements.size());
+  }
+
+  // Answers every suggestion until the graph holds n log2 n judgements; the cost is per suggestion
+  bench::Record benchQuestionSelector(size_t n) {
+    const size_t target = static_cast<size_t>(n * std::log2(static_cast<double>(n)));
+    size_t questions = 0;
+    double connectivity = 0.0;
+    auto m = bench::measure([&] {
+      AHP::QuestionSelector selector(n);
+      questions = 0;
+      while (selector.judged() < target) {
+        const auto pair = selector.next();
+        selector.addJudgement(pair->first, pair->second);
+        questions++;
+      }
+      connectivity = selector.algebraicConnectivity();
+    }, 0.2, 1);
+
+    bench::Measurement perQuestion = m;
+    perQuestion.nsPerOp /= questions;
+    perQuestion.bestNs /= questions;
+    return baseRecord("QuestionSelector/next", 1, 1, n, 1.0, perQuestion)
+      .add("questions", questions)
+      .add("algebraic_connectivity", connectivity);
+  }
+
+  // One random index simulation at the default sample count, as the webserver runs it for a new survey size
+  bench::Record benchRandomIndex(size_t n, AHP::PriorityMethod method, const char* name) {
+    const size_t samples = AHP::defaultRandomIndexSamples(n);
+    double ri = 0.0;
+    auto m = bench::measure([&] {
+      ri = AHP::simulateRandomIndex(n, samples, method);
+    }, 0.2, 1);
+    return baseRecord(std::string("simulateRandomIndex/") + name, 1, 1, n, static_cast<double>(samples * n * n), m)
+      .add("samples", samples)
+      .add("random_index", ri);
+  }
+
+  // Eigenvector method on aggregates alternating between two nearby states; cold runs drop the previous weights
+  bench::Record benchEigenvector(size_t criteria, size_t alternatives, bool warm, std::mt19937_64& rng) {
+    std::array<AHP::Matrix2D, 2> critMatrix;
+    std::array<std::vector<AHP::Matrix2D>, 2> altMatrices;
+    critMatrix[0] = nearConsistentMatrix(criteria, 0.3, rng);
+    critMatrix[1] = perturbed(critMatrix[0], 0.01, rng);
+    for (size_t i = 0; i < criteria; i++) {
+      altMatrices[0].push_back(nearConsistentMatrix(alternatives, 0.3, rng));
+      altMatrices[1].push_back(perturbed(altMatrices[0].back(), 0.01, rng));
+    }
+
+    AHP::AHPRanker ranker(AHP::PriorityMethod::Eigenvector);
+    AHP::RankingWorkspace ws;
+    size_t state = 0;
+    std::uint64_t products = 0;
+    std::uint64_t rankings = 0;
+    auto m = bench::measure([&] {
+      state ^= 1;
+      ws.hasWeights = ws.hasWeights && warm;
+      ranker.calculateRanking(critMatrix[state], altMatrices[state], ws);
+      products += ws.powerIterations;
+      rankings++;
+      bench::doNotOptimize(ws.ranking.data());
+    });
+
+    const double cells = static_cast<double>(criteria * criteria + criteria * alternatives * alternatives);
+    return baseRecord(warm ? "AHPRanker/eigenvector-warm" : "AHPRanker/eigenvector-cold", 1, criteria, alternatives, cells, m)
+      .add("power_iterations_per_matrix", static_cast<double>(products) / (rankings * (criteria + 1)));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const bool quick = bench::hasFlag(argc, argv, "--quick");
+  const std::string outPath = bench::flagValue(argc, argv, "--out", "");
+
+  const std::vector<size_t> sizeSweep = quick ? std::vector<size_t>{2, 10, 100}
+                                              : std::vector<size_t>{2, 5, 10, 50, 100, 500, 1000};
+  const std::vector<size_t> agentSweep = quick ? std::vector<size_t>{1, 100, 1000}
+                                               : std::vector<size_t>{1, 10, 100, 1000, 10000, 100000};
+  const std::vector<size_t> criteriaSweep = quick ? std::vector<size_t>{2, 10}
+                                                  : std::vector<size_t>{2, 5, 10, 20, 50};
+
+  std::mt19937_64 rng(42);
+  std::vector<bench::Record> records;
+
+  for (size_t n : sizeSweep) {
+    records.push_back(benchBuildMatrix(n, rng));
+  }
+
+  // Aggregation: agents at a typical survey size, then criteria and alternatives at a moderate panel
+  for (size_t agents : agentSweep) {
+    records.push_back(benchMean(agents, 5, 5, rng));
+  }
+  for (size_t criteria : criteriaSweep) {
+    records.push_back(benchMean(100, criteria, 10, rng));
+  }
+  for (size_t alternatives : sizeSweep) {
+    if (alternatives <= 500)
+      records.push_back(benchMean(10, 3, alternatives, rng));
+  }
+  for (size_t agents : agentSweep) {
+    if (agents <= 10000) {
+      records.push_back(benchSetWeight(agents, 5, 10, rng));
+      records.push_back(benchConsensus(agents, 5, 10, rng));
+    }
+  }
+  for (size_t agents : agentSweep) {
+    if (agents <= 10000) {
+      records.push_back(benchIndividualPriorities(agents, 5, 10, rng));
+      records.push_back(benchIndividualSubmit(agents, 5, 10, rng));
+      records.push_back(benchLeaveOneOut(agents, 5, 10, rng));
+      records.push_back(benchBootstrap(agents, 5, 10, rng));
+    }
+  }
+
+  for (size_t criteria : criteriaSweep) {
+    records.push_back(benchRanking(criteria, 10, rng));
+  }
+  for (size_t alternatives : sizeSweep) {
+    records.push_back(benchRanking(5, alternatives, rng));
+  }
+
+  bool allocationFree = true;
+  for (size_t criteria : criteriaSweep) {
+    records.push_back(benchRankingWorkspace(criteria, 10, rng, allocationFree));
+  }
+  for (size_t alternatives : sizeSweep) {
+    records.push_back(benchRankingWorkspace(5, alternatives, rng, allocationFree));
+  }
+  // Square surveys around the geometric mean's fixed-size cutoff, 6 is the first size on the dynamic path
+  const std::vector<size_t> smallSweep = quick ? std::vector<size_t>{3, 5, 6, 16}
+                                               : std::vector<size_t>{3, 4, 5, 6, 7, 9, 12, 16, 17};
+  for (size_t n : smallSweep) {
+    records.push_back(benchRankingWorkspace(n, n, rng, allocationFree));
+  }
+
+  // Crossover of the fixed-size kernels; sizes past the policy cutoffs up to FixedKernelSizes show where
+  // they lose
+  const std::vector<size_t> kernelSweep = quick ? std::vector<size_t>{3, 9, 16}
+                                                : std::vector<size_t>{2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  const std::array<std::pair<AHP::PriorityMethod, const char*>, AHP::PriorityMethodCount> methods = {{
+    {AHP::PriorityMethod::GeometricMean, "geometricMean"},
+    {AHP::PriorityMethod::Eigenvector, "eigenvector"},
+    {AHP::PriorityMethod::ColumnAverage, "columnAverage"},
+    {AHP::PriorityMethod::LogLeastSquares, "logLeastSquares"},
+  }};
+  for (auto [method, name] : methods) {
+    for (size_t n : kernelSweep) {
+      records.push_back(benchKernelPath(method, name, n, rng));
+    }
+  }
+
+  for (size_t alternatives : quick ? std::vector<size_t>{10, 100} : std::vector<size_t>{10, 100, 500}) {
+    records.push_back(benchTracingOverhead(100, 5, alternatives, rng));
+  }
+
+  // Wide survey for thread scaling, compare runs with different AHP_THREADS
+  records.push_back(benchMean(10, 30, 500, rng));
+  records.push_back(benchRankingWorkspace(30, 500, rng, allocationFree));
+
+  for (size_t alternatives : sizeSweep) {
+    for (auto [method, name] : methods) {
+      records.push_back(benchPriorityMethod(method, name, 5, alternatives, rng));
+    }
+  }
+
+  for (size_t alternatives : sizeSweep) {
+    records.push_back(benchEigenvector(5, alternatives, false, rng));
+    records.push_back(benchEigenvector(5, alternatives, true, rng));
+  }
+
+  for (size_t alternatives : quick ? std::vector<size_t>{10, 100} : std::vector<size_t>{10, 100, 1000}) {
+    records.push_back(benchSensitivity(10, alternatives, rng));
+    records.push_back(benchWhatIf(10, alternatives, rng));
+  }
+
+  // networks of 500, 2000 and 4000 nodes
+  for (auto [clusters, perCluster, dependencies] : quick ? std::vector<std::array<size_t, 3>>{{10, 50, 3}}
+                                                         : std::vector<std::array<size_t, 3>>{{10, 50, 3}, {40, 50, 4}, {100, 40, 3}}) {
+    for (auto& record : benchNetwork(clusters, perCluster, dependencies, rng)) {
+      records.push_back(record);
+    }
+  }
+
+  for (size_t n : quick ? std::vector<size_t>{10, 100} : std::vector<size_t>{10, 100, 500}) {
+    records.push_back(benchDiagnostics(n, 0, rng));
+  }
+  records.push_back(benchDiagnostics(quick ? 1000 : 2000, AHP::TriadSamples, rng));
+
+  for (size_t alternatives : quick ? std::vector<size_t>{10, 100} : std::vector<size_t>{10, 100, 500}) {
+    for (auto& record : benchFuzzy(100, 5, alternatives, rng)) {
+      records.push_back(record);
+    }
+  }
+
+  // 4 levels, 128 leaf criteria
+  records.push_back(benchHierarchy({4, 4, 4, 2}, false, rng));
+  records.push_back(benchHierarchy({4, 4, 4, 2}, true, rng));
+
+  // 10 criteria x 20 alternatives; the per-survey path of the eigenvector method gets fewer simulations
+  const size_t simulations = quick ? 10000 : 100000;
+  records.push_back(benchUncertainty(AHP::PriorityMethod::GeometricMean, "geometricMean", AHP::JudgementNoise::SaatyStep,
+                                     "saatyStep", simulations, 10, 20, rng));
+  records.push_back(benchUncertainty(AHP::PriorityMethod::GeometricMean, "geometricMean", AHP::JudgementNoise::LogNormal,
+                                     "logNormal", simulations, 10, 20, rng));
+  records.push_back(benchUncertainty(AHP::PriorityMethod::Eigenvector, "eigenvector", AHP::JudgementNoise::SaatyStep,
+                                     "saatyStep", simulations / 10, 10, 20, rng));
+
+  // Incomplete matrices, ns_per_cell is per judgement here
+  for (size_t n : quick ? std::vector<size_t>{100, 1000} : std::vector<size_t>{100, 1000, 10000, 100000}) {
+    records.push_back(benchSparseWeights(n, rng));
+  }
+
+  for (size_t n : quick ? std::vector<size_t>{100} : std::vector<size_t>{100, 1000}) {
+    records.push_back(benchQuestionSelector(n));
+  }
+
+  for (size_t n : quick ? std::vector<size_t>{20, 100} : std::vector<size_t>{20, 100, 1000}) {
+    records.push_back(benchRandomIndex(n, AHP::PriorityMethod::GeometricMean, "geometricMean"));
+    records.push_back(benchRandomIndex(n, AHP::PriorityMethod::Eigenvector, "eigenvector"));
+  }
+
+  const std::string out = bench::report("ahp_bench", records);
+  if (outPath.empty()) {
+    std::cout << out;
+  } else {
+    std::ofstream(outPath) << out;
+  }
+
+  if (!allocationFree) {
+    std::cerr << "Steady-state workspace ranking allocated on the heap\n";
+    return 1;
+  }
+}
@@ -0,0 +1,264 @@
+#include "bench_utils.h"
+
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include <asio.hpp>
+
+// Drives a running webserver with a setup followed by a mix of /submit, /results and /static requests.
+// Usage: ahp_loadgen [--host H] [--port P] [--concurrency C] [--duration SECONDS]
+//                    [--criteria N] [--alternatives N] [--mix SUBMIT,RESULTS,STATIC] [--seed S] [--out FILE]
+
+namespace
+{
+  constexpr std::array<const char*, 17> kSaatyScale = {
+    "0.1111", "0.125", "0.1429", "0.1667", "0.2", "0.25", "0.3333", "0.5", "1",
+    "2", "3", "4", "5", "6", "7", "8", "9"
+  };
+
+  enum class RequestKind { Submit, Results, Static };
+  constexpr std::array<const char*, 3> kKindNames = { "submit", "results", "static" };
+
+  struct Options {
+    std::string host;
+    std::string port;
+    size_t concurrency;
+    double durationSeconds;
+    size_t criteria;
+    size_t alternatives;
+    std::array<double, 3> mix;
+    std::uint64_t seed;
+  };
+
+  struct Sample {
+    RequestKind kind;
+    std::uint64_t latencyNs;
+    bool ok;
+  };
+
+  std::string urlEncode(const std::string& str) {
+    std::string out;
+    for (unsigned char c : str) {
+      if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+        out += static_cast<char>(c);
+      } else {
+        out += fmt::format("%{:02X}", c);
+      }
+    }
+    return out;
+  }
+
+  std::vector<std::string> names(const std::string& prefix, size_t count) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; i++) {
+      result.push_back(prefix + std::to_string(i));
+    }
+    return result;
+  }
+
+  // Random reciprocal judgements in the same shape the frontend submits
+  std::string matrixJson(const std::vector<std::string>& items, std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> pick(0, kSaatyScale.size() - 1);
+    const size_t n = items.size();
+    std::vector<size_t> upper(n * n, 8);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = i + 1; j < n; j++) {
+        upper[i * n + j] = pick(rng);
+        upper[j * n + i] = kSaatyScale.size() - 1 - upper[i * n + j];
+      }
+    }
+
+    std::string out = "{";
+    for (size_t i = 0; i < n; i++) {
+      out += fmt::format("{}\"{}\":{{", i ? "," : "", items[i]);
+      for (size_t j = 0; j < n; j++) {
+        out += fmt::format("{}\"{}\":", j ? "," : "", items[j]);
+        out += i == j ? "1" : fmt::format("\"{}\"", kSaatyScale[upper[i * n + j]]);
+      }
+      out += "}";
+    }
+    return out + "}";
+  }
+
+  std::string agentInputJson(const std::vector<std::string>& criteria, const std::vector<std::string>& alternatives,
+                             std::mt19937_64& rng) {
+    std::string out = "{\"criteriaMatrix\":" + matrixJson(criteria, rng) + ",\"alternativeMatrices\":{";
+    for (size_t i = 0; i < criteria.size(); i++) {
+      out += fmt::format("{}\"{}\":{}", i ? "," : "", criteria[i], matrixJson(alternatives, rng));
+    }
+    return out + "}}";
+  }
+
+  // One request per connection; the server closes most connections itself anyway
+  bool httpGet(asio::io_context& io, const asio::ip::tcp::resolver::results_type& endpoints,
+               const std::string& host, const std::string& target) {
+    asio::ip::tcp::socket socket(io);
+    asio::error_code ec;
+    asio::connect(socket, endpoints, ec);
+    if (ec)
+      return false;
+
+    const std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: {}\r\nConnection: close\r\n\r\n", target, host);
+    asio::write(socket, asio::buffer(request), ec);
+    if (ec)
+      return false;
+
+    std::string response;
+    std::array<char, 16384> chunk;
+    for (;;) {
+      const size_t read = socket.read_some(asio::buffer(chunk), ec);
+      response.append(chunk.data(), read);
+      if (ec)
+        break;
+    }
+    if (ec != asio::error::eof && ec != asio::error::connection_reset)
+      return false;
+
+    return response.starts_with("HTTP/1.1 200") || response.starts_with("HTTP/1.0 200");
+  }
+
+  double percentile(const std::vector<std::uint64_t>& sorted, double q) {
+    if (sorted.empty())
+      return 0.0;
+    const size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)] * 1e-6;
+  }
+
+  bench::Record summarize(const std::string& route, std::vector<std::uint64_t> latencies, size_t errors, double seconds) {
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0.0;
+    for (auto ns : latencies) {
+      sum += static_cast<double>(ns);
+    }
+
+    bench::Record record;
+    record.add("route", route)
+      .add("requests", latencies.size())
+      .add("errors", errors)
+      .add("duration_s", seconds)
+      .add("requests_per_second", latencies.size() / seconds)
+      .add("mean_ms", latencies.empty() ? 0.0 : sum / latencies.size() * 1e-6)
+      .add("p50_ms", percentile(latencies, 0.5))
+      .add("p99_ms", percentile(latencies, 0.99))
+      .add("p999_ms", percentile(latencies, 0.999))
+      .add("max_ms", latencies.empty() ? 0.0 : latencies.back() * 1e-6);
+    return record;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Options opts;
+  opts.host = bench::flagValue(argc, argv, "--host", "127.0.0.1");
+  opts.port = bench::flagValue(argc, argv, "--port", "8080");
+  opts.concurrency = std::stoul(bench::flagValue(argc, argv, "--concurrency", "8"));
+  opts.durationSeconds = std::stod(bench::flagValue(argc, argv, "--duration", "10"));
+  opts.criteria = std::stoul(bench::flagValue(argc, argv, "--criteria", "5"));
+  opts.alternatives = std::stoul(bench::flagValue(argc, argv, "--alternatives", "5"));
+  opts.seed = std::stoull(bench::flagValue(argc, argv, "--seed", "1"));
+  const std::string outPath = bench::flagValue(argc, argv, "--out", "");
+
+  const std::string mix = bench::flagValue(argc, argv, "--mix", "70,20,10");
+  if (std::sscanf(mix.c_str(), "%lf,%lf,%lf", &opts.mix[0], &opts.mix[1], &opts.mix[2]) != 3) {
+    std::cerr << "Invalid --mix, expected SUBMIT,RESULTS,STATIC weights\n";
+    return 1;
+  }
+
+  const auto criteria = names("crit", opts.criteria);
+  const auto alternatives = names("alt", opts.alternatives);
+
+  asio::io_context io;
+  const auto endpoints = asio::ip::tcp::resolver(io).resolve(opts.host, opts.port);
+
+  const std::string setupJson = fmt::format("{{\"criteria\":[\"{}\"],\"alternatives\":[\"{}\"]}}",
+    fmt::join(criteria, "\",\""), fmt::join(alternatives, "\",\""));
+  if (!httpGet(io, endpoints, opts.host, "/submitSetup?data=" + urlEncode(setupJson))) {
+    std::cerr << "Setup request failed, is the webserver running on " << opts.host << ":" << opts.port << "?\n";
+    return 1;
+  }
+
+  // Results need at least one submission to be meaningful
+  std::mt19937_64 setupRng(opts.seed);
+  httpGet(io, endpoints, opts.host, "/submit?data=" + urlEncode(agentInputJson(criteria, alternatives, setupRng)));
+
+  std::atomic<bool> stop{false};
+  std::vector<std::vector<Sample>> samples(opts.concurrency);
+  std::vector<std::thread> workers;
+
+  const auto start = bench::Clock::now();
+  for (size_t w = 0; w < opts.concurrency; w++) {
+    workers.emplace_back([&, w] {
+      asio::io_context workerIo;
+      std::mt19937_64 rng(opts.seed * 1000003 + w + 1);
+      std::discrete_distribution<int> pickKind(opts.mix.begin(), opts.mix.end());
+
+      while (!stop.load(std::memory_order_relaxed)) {
+        const auto kind = static_cast<RequestKind>(pickKind(rng));
+        std::string target;
+        switch (kind) {
+          case RequestKind::Submit:
+            target = "/submit?data=" + urlEncode(agentInputJson(criteria, alternatives, rng));
+            break;
+          case RequestKind::Results:
+            target = "/results";
+            break;
+          default:
+            target = "/static/styles.css";
+            break;
+        }
+
+        const auto requestStart = bench::Clock::now();
+        const bool ok = httpGet(workerIo, endpoints, opts.host, target);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(bench::Clock::now() - requestStart).count();
+        samples[w].push_back({kind, static_cast<std::uint64_t>(ns), ok});
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(opts.durationSeconds));
+  stop = true;
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  const double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+
+  std::vector<std::uint64_t> all;
+  std::array<std::vector<std::uint64_t>, 3> byKind;
+  size_t errors = 0;
+  std::array<size_t, 3> errorsByKind{};
+  for (auto& workerSamples : samples) {
+    for (auto& sample : workerSamples) {
+      const auto kindIdx = static_cast<size_t>(sample.kind);
+      if (!sample.ok) {
+        errors++;
+        errorsByKind[kindIdx]++;
+        continue;
+      }
+      all.push_back(sample.latencyNs);
+      byKind[kindIdx].push_back(sample.latencyNs);
+    }
+  }
+
+  std::vector<bench::Record> records;
+  records.push_back(summarize("all", std::move(all), errors, seconds)
+    .add("concurrency", opts.concurrency)
+    .add("criteria", opts.criteria)
+    .add("alternatives", opts.alternatives));
+  for (size_t k = 0; k < byKind.size(); k++) {
+    records.push_back(summarize(kKindNames[k], std::move(byKind[k]), errorsByKind[k], seconds));
+  }
+
+  const std::string out = bench::report("ahp_loadgen", records);
+  if (outPath.empty()) {
+    std::cout << out;
+  } else {
+    std::ofstream(outPath) << out;
+  }
+}
@@ -0,0 +1,74 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+// glibc's own allocator entry points, which the replacements below forward to
+extern "C" {
+  void* __libc_malloc(std::size_t size);
+  void* __libc_calloc(std::size_t count, std::size_t size);
+  void* __libc_realloc(void* ptr, std::size_t size);
+  void* __libc_memalign(std::size_t alignment, std::size_t size);
+  void __libc_free(void* ptr);
+}
+
+namespace
+{
+  std::atomic<std::uint64_t> allocations{0};
+
+  void count() {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void* newAlloc(std::size_t size) {
+    if (void* ptr = std::malloc(size ? size : 1))
+      return ptr;
+    throw std::bad_alloc();
+  }
+
+  void* newAlignedAlloc(std::size_t size, std::align_val_t align) {
+    const auto alignment = static_cast<std::size_t>(align);
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+      return ptr;
+    throw std::bad_alloc();
+  }
+}
+
+std::uint64_t bench::allocationCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+// Replacing malloc and its relatives catches Eigen's dynamic storage (internal::aligned_malloc calls std::malloc),
+// the standard library and operator new alike
+extern "C" {
+  void* malloc(std::size_t size) noexcept { count(); return __libc_malloc(size); }
+  void* calloc(std::size_t n, std::size_t size) noexcept { count(); return __libc_calloc(n, size); }
+  void* realloc(void* ptr, std::size_t size) noexcept { count(); return __libc_realloc(ptr, size); }
+  void* memalign(std::size_t alignment, std::size_t size) noexcept { count(); return __libc_memalign(alignment, size); }
+  void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept { count(); return __libc_memalign(alignment, size); }
+  int posix_memalign(void** out, std::size_t alignment, std::size_t size) noexcept {
+    count();
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr)
+      return ENOMEM;
+    *out = ptr;
+    return 0;
+  }
+  void free(void* ptr) noexcept { __libc_free(ptr); }
+}
+
+void* operator new(std::size_t size) { return newAlloc(size); }
+void* operator new[](std::size_t size) { return newAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return newAlignedAlloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return newAlignedAlloc(size, align); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
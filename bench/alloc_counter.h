@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts heap allocations: malloc and its relatives, which Eigen's dynamic storage and operator new go through.
+// Link alloc_counter.cpp into a benchmark or test to enable it.
+namespace bench
+{
+  std::uint64_t allocationCount();   // total since process start, across all threads
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include <sys/resource.h>
+
+// Small self-contained harness shared by the benchmark executables
+namespace bench
+{
+  using Clock = std::chrono::steady_clock;
+
+  template <typename T>
+  inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  struct Measurement {
+    std::uint64_t iterations = 0;
+    double nsPerOp = 0.0;     // mean over the timed iterations
+    double bestNs = 0.0;      // fastest single iteration
+    double medianNs = 0.0;    // only filled in by summarize()
+  };
+
+  // Runs `op` once to warm up, then repeatedly until `minSeconds` have elapsed (at least `minIterations` times)
+  template <typename Op>
+  Measurement measure(Op&& op, double minSeconds = 0.2, std::uint64_t minIterations = 3) {
+    op();
+
+    Measurement m;
+    m.bestNs = 1e300;
+    double totalNs = 0.0;
+    while (m.iterations < minIterations || totalNs < minSeconds * 1e9) {
+      const auto start = Clock::now();
+      op();
+      const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+      totalNs += ns;
+      m.bestNs = std::min(m.bestNs, ns);
+      m.iterations++;
+    }
+    m.nsPerOp = totalNs / m.iterations;
+    return m;
+  }
+
+  // Measurement of individually timed iterations, for benchmarks that interleave cases
+  inline Measurement summarize(std::vector<double> samplesNs) {
+    Measurement m;
+    if (samplesNs.empty())
+      return m;
+    std::sort(samplesNs.begin(), samplesNs.end());
+    m.iterations = samplesNs.size();
+    for (double ns : samplesNs)
+      m.nsPerOp += ns;
+    m.nsPerOp /= samplesNs.size();
+    m.bestNs = samplesNs.front();
+    const size_t mid = samplesNs.size() / 2;
+    m.medianNs = samplesNs.size() % 2 ? samplesNs[mid] : (samplesNs[mid - 1] + samplesNs[mid]) / 2;
+    return m;
+  }
+
+  // Process-wide high-water mark, so it only ever grows across a sweep
+  inline long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+  // One flat JSON object per benchmark case
+  class Record {
+  public:
+    Record& add(const std::string& key, const std::string& value) {
+      fields_.emplace_back(key, fmt::format("\"{}\"", value));
+      return *this;
+    }
+    Record& add(const std::string& key, const char* value) {
+      return add(key, std::string(value));
+    }
+    template <typename Number>
+    Record& add(const std::string& key, Number value) {
+      fields_.emplace_back(key, fmt::format("{}", value));
+      return *this;
+    }
+
+    std::string json() const {
+      std::string out = "{";
+      for (size_t i = 0; i < fields_.size(); i++) {
+        out += fmt::format("{}\"{}\": {}", i ? ", " : "", fields_[i].first, fields_[i].second);
+      }
+      return out + "}";
+    }
+
+  private:
+    std::vector<std::pair<std::string, std::string>> fields_;
+  };
+
+  inline std::string report(const std::string& name, const std::vector<Record>& records) {
+    std::string out = fmt::format("{{\n  \"benchmark\": \"{}\",\n  \"results\": [", name);
+    for (size_t i = 0; i < records.size(); i++) {
+      out += fmt::format("{}\n    {}", i ? "," : "", records[i].json());
+    }
+    return out + "\n  ]\n}\n";
+  }
+
+  inline bool hasFlag(int argc, char** argv, const std::string& flag) {
+    for (int i = 1; i < argc; i++) {
+      if (argv[i] == flag)
+        return true;
+    }
+    return false;
+  }
+
+  inline std::string flagValue(int argc, char** argv, const std::string& flag, const std::string& fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+      if (argv[i] == flag)
+        return argv[i + 1];
+    }
+    return fallback;
+  }
+}
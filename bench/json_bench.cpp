@@ -0,0 +1,88 @@
+#include "alloc_counter.h"
+#include "bench_utils.h"
+#include "json_corpus.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// Times json_handling::parseSetup and parseAgentInput over the corpus and checks every result against it.
+// Usage: json_bench [--quick] [--out FILE] [--dump DIR]
+// --dump writes the corpus payloads to DIR so that other parsers can be checked against the same inputs.
+
+namespace
+{
+  template <typename Parse>
+  bench::Record benchParse(const std::string& parser, const bench::CorpusCase& c, const std::string& payload,
+                           size_t judgements, double minSeconds, Parse&& parse) {
+    const auto allocsBefore = bench::allocationCount();
+    bench::doNotOptimize(parse(payload));
+    const auto allocsPerParse = bench::allocationCount() - allocsBefore;
+
+    auto m = bench::measure([&] {
+      bench::doNotOptimize(parse(payload));
+    }, minSeconds);
+
+    bench::Record record;
+    record.add("kernel", parser)
+      .add("case", c.name)
+      .add("criteria", c.criteria.size())
+      .add("alternatives", c.alternatives.size())
+      .add("bytes", payload.size())
+      .add("judgements", judgements)
+      .add("iterations", m.iterations)
+      .add("ns_per_parse", m.nsPerOp)
+      .add("ns_per_byte", m.nsPerOp / payload.size())
+      .add("ns_per_judgement", judgements ? m.nsPerOp / judgements : 0.0)
+      .add("megabytes_per_second", payload.size() * 1e3 / m.nsPerOp)
+      .add("allocations_per_parse", allocsPerParse);
+    return record;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const bool quick = bench::hasFlag(argc, argv, "--quick");
+  const std::string outPath = bench::flagValue(argc, argv, "--out", "");
+  const std::string dumpDir = bench::flagValue(argc, argv, "--dump", "");
+  const double minSeconds = quick ? 0.02 : 0.2;
+
+  const auto corpus = bench::buildCorpus();
+
+  if (!dumpDir.empty()) {
+    std::filesystem::create_directories(dumpDir);
+    for (auto& c : corpus) {
+      std::ofstream(std::filesystem::path(dumpDir) / (c.name + ".setup.json")) << c.setupJson;
+      std::ofstream(std::filesystem::path(dumpDir) / (c.name + ".agent.json")) << c.agentJson;
+    }
+  }
+
+  bool conformant = true;
+  for (auto& c : corpus) {
+    const std::string error = bench::checkConformance(c, json_handling::parseSetup(c.setupJson),
+                                                      json_handling::parseAgentInput(c.agentJson));
+    if (!error.empty()) {
+      std::cerr << "Conformance failure in case " << c.name << ": " << error << "\n";
+      conformant = false;
+    }
+  }
+
+  std::vector<bench::Record> records;
+  for (auto& c : corpus) {
+    if (quick && c.judgements > 20000)
+      continue;
+    records.push_back(benchParse("parseSetup", c, c.setupJson, c.criteria.size() + c.alternatives.size(), minSeconds,
+      [](const std::string& json) { return json_handling::parseSetup(json); }));
+    records.push_back(benchParse("parseAgentInput", c, c.agentJson, c.judgements, minSeconds,
+      [](const std::string& json) { return json_handling::parseAgentInput(json); }));
+  }
+
+  const std::string out = bench::report("json_bench", records);
+  if (outPath.empty()) {
+    std::cout << out;
+  } else {
+    std::ofstream(outPath) << out;
+  }
+
+  return conformant ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "json_handling.h"
+
+#include <array>
+#include <random>
+#include <fmt/format.h>
+
+// Deterministic corpus of setup and agent payloads together with the values a conforming parser must produce.
+// The same corpus is meant to validate any replacement of the simpleson based parser.
+namespace bench
+{
+  struct CorpusCase {
+    std::string name;
+    std::vector<std::string> criteria;
+    std::vector<std::string> alternatives;
+    std::string setupJson;
+    std::string agentJson;
+    json_handling::AgentInput expected;
+    size_t judgements = 0;   // comparison entries in agentJson
+  };
+
+  enum class ValueStyle { Strings, Numbers };
+
+  namespace detail {
+    constexpr std::array<const char*, 17> kSaatyScale = {
+      "0.1111", "0.125", "0.1429", "0.1667", "0.2", "0.25", "0.3333", "0.5", "1",
+      "2", "3", "4", "5", "6", "7", "8", "9"
+    };
+
+    inline std::string matrixJson(const std::vector<std::string>& items, AHP::Comparisons& expected,
+                                  size_t& judgements, ValueStyle style, const char* sep, std::mt19937_64& rng) {
+      std::uniform_int_distribution<size_t> pick(0, kSaatyScale.size() - 1);
+      const size_t n = items.size();
+      std::vector<size_t> scaleIdx(n * n, 8);
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+          scaleIdx[i * n + j] = pick(rng);
+          scaleIdx[j * n + i] = kSaatyScale.size() - 1 - scaleIdx[i * n + j];
+        }
+      }
+
+      std::string out = "{";
+      for (size_t i = 0; i < n; i++) {
+        out += fmt::format("{}{}\"{}\":{}{{", i ? "," : "", sep, items[i], sep);
+        for (size_t j = 0; j < n; j++) {
+          const char* value = kSaatyScale[scaleIdx[i * n + j]];
+          out += fmt::format("{}\"{}\":{}", j ? "," : "", items[j], sep);
+          out += (style == ValueStyle::Strings && i != j) ? fmt::format("\"{}\"", value) : std::string(value);
+          expected[items[i]][items[j]] = std::stod(value);
+          judgements++;
+        }
+        out += "}";
+      }
+      return out + sep + "}";
+    }
+  } // namespace detail
+
+  inline CorpusCase makeCorpusCase(size_t criteriaCount, size_t alternativeCount, ValueStyle style, bool pretty,
+                                   std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const char* sep = pretty ? "\n  " : "";
+
+    CorpusCase c;
+    c.name = fmt::format("{}x{}{}{}", alternativeCount, criteriaCount,
+      style == ValueStyle::Numbers ? "-numbers" : "", pretty ? "-pretty" : "");
+    for (size_t i = 0; i < criteriaCount; i++) {
+      c.criteria.push_back(fmt::format("criterion {}", i));
+    }
+    for (size_t i = 0; i < alternativeCount; i++) {
+      c.alternatives.push_back(fmt::format("alternative_{}", i));
+    }
+
+    c.setupJson = fmt::format("{{{}\"criteria\":[\"{}\"],{}\"alternatives\":[\"{}\"]{}}}",
+      sep, fmt::join(c.criteria, "\",\""), sep, fmt::join(c.alternatives, "\",\""), sep);
+
+    c.agentJson = fmt::format("{{{}\"criteriaMatrix\":", sep);
+    c.agentJson += detail::matrixJson(c.criteria, c.expected.critComparisons, c.judgements, style, sep, rng);
+    c.agentJson += fmt::format(",{}\"alternativeMatrices\":{{", sep);
+    for (size_t i = 0; i < criteriaCount; i++) {
+      c.agentJson += fmt::format("{}{}\"{}\":", i ? "," : "", sep, c.criteria[i]);
+      c.agentJson += detail::matrixJson(c.alternatives, c.expected.altComparisons[c.criteria[i]], c.judgements, style, sep, rng);
+    }
+    c.agentJson += fmt::format("}}{}}}", sep);
+
+    return c;
+  }
+
+  // Payloads from 2x2 up to 100 alternatives x 20 criteria, plus formatting variants of a mid-sized survey
+  inline std::vector<CorpusCase> buildCorpus() {
+    const std::vector<std::pair<size_t, size_t>> sizes = {   // {criteria, alternatives}
+      {2, 2}, {3, 5}, {5, 5}, {5, 10}, {10, 20}, {10, 50}, {20, 100}
+    };
+
+    std::vector<CorpusCase> corpus;
+    std::uint64_t seed = 1;
+    for (auto [criteria, alternatives] : sizes) {
+      corpus.push_back(makeCorpusCase(criteria, alternatives, ValueStyle::Strings, false, seed++));
+    }
+    corpus.push_back(makeCorpusCase(5, 10, ValueStyle::Numbers, false, seed++));
+    corpus.push_back(makeCorpusCase(5, 10, ValueStyle::Strings, true, seed++));
+    return corpus;
+  }
+
+  // Returns an empty string when the parser output matches the corpus, otherwise the first difference
+  inline std::string checkConformance(const CorpusCase& c, const json_handling::SetupData& setup,
+                                      const json_handling::AgentInput& input) {
+    if (setup.alternatives != c.alternatives)
+      return "setup alternatives differ";
+    if (setup.criteria != c.criteria)
+      return "setup criteria differ";
+    if (input.critComparisons != c.expected.critComparisons)
+      return "criteria comparisons differ";
+    if (input.altComparisons != c.expected.altComparisons)
+      return "alternative comparisons differ";
+    if (input.weight != c.expected.weight)
+      return "agent weight differs";
+    return "";
+  }
+}
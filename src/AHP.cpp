@@ -1,10 +1,25 @@
 #include "AHP.h"
+#include "RandomIndex.h"
+#include "parallel.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <utility>
 #include <numeric>
+#include <random>
 #include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/Sparse>
 
 /*    AHP HELPERS     */
 
 AHP::Matrix2D AHP::buildMatrix(const AHP::Comparisons& comparisons, const std::vector<std::string>& alternatives) {
+  tracing::Span span("buildMatrix");
   const size_t n = alternatives.size();
   AHP::Matrix2D matrix = AHP::Matrix2D::Ones(n, n);
 
@@ -26,155 +41,926 @@ AHP::Matrix2D AHP::buildMatrix(const AHP::Comparisons& comparisons, const std::v
   return matrix;
 }
 
-AHP::AHPMeanCalculator::AHPMeanCalculator(const std::vector<std::string>& criteria) : criteria_(criteria) {};
+AHP::AHPMeanCalculator::AHPMeanCalculator(const std::vector<std::string>& criteria)
+  : altLogs_(criteria.size()), criteria_(criteria) {};
+
+namespace {
+  // West's weighted Welford update of the second central moment for a change of `weight` in the weight of `logs`
+  void updateM2(Eigen::VectorXd& m2, const Eigen::VectorXd& logSum, Eigen::Ref<const Eigen::VectorXd> logs,
+                double weight, double weightSum) {
+    const double newSum = weightSum + weight;
+    if (!(newSum > 0.0)) {
+      m2.setZero();
+    } else if (weightSum > 0.0) {
+      m2 += (weight * weightSum / newSum) * (logs - logSum / weightSum).cwiseAbs2();
+    }
+  }
+}
+
+void AHP::AHPMeanCalculator::LogBlocks::add(const AHP::Matrix2D& matrix, double weight, double weightSum) {
+  if (logs.empty()) {
+    n = matrix.rows();
+    logSum = Eigen::VectorXd::Zero(n * n);
+    logM2 = Eigen::VectorXd::Zero(n * n);
+  } else if (matrix.rows() != n || matrix.cols() != n) {
+    throw std::invalid_argument("Comparison matrix size differs from earlier agents");
+  }
+
+  const size_t offset = logs.size();
+  logs.resize(offset + n * n);
+  Eigen::Map<Eigen::VectorXd> agent_logs(logs.data() + offset, n * n);
+  agent_logs = matrix.reshaped().array().log();
+  updateM2(logM2, logSum, agent_logs, weight, weightSum);
+  logSum += weight * agent_logs;
+}
+
+void AHP::AHPMeanCalculator::LogBlocks::reweigh(size_t agent, double delta, double weightSum) {
+  const Eigen::Map<const Eigen::VectorXd> agent_logs(logs.data() + agent * n * n, n * n);
+  updateM2(logM2, logSum, agent_logs, delta, weightSum);
+  logSum += delta * agent_logs;
+}
+
+AHP::MatrixConsensus AHP::AHPMeanCalculator::LogBlocks::consensus(double weightSum) const {
+  const Eigen::Map<const AHP::Matrix2D> sums(logSum.data(), n, n), m2(logM2.data(), n, n);
+  // ln of the group's geometric mean priorities, up to a constant that cancels in their ratios
+  const Eigen::VectorXd logWeights = sums.rowwise().mean() / weightSum;
+
+  AHP::MatrixConsensus result{0.0, 0.0, 0.0, 0, std::min<Eigen::Index>(n - 1, 1)};
+  double squares = 0.0;
+  for (Eigen::Index j = 1; j < n; j++) {
+    for (Eigen::Index i = 0; i < j; i++) {
+      // sum_k w_k (ln a_ij^k - ln w_i / w_j)^2 / W splits into the variance and the mean's own error
+      const double variance = std::max(m2(i, j), 0.0) / weightSum;
+      const double error = sums(i, j) / weightSum - logWeights(i) + logWeights(j);
+      squares += variance + error * error;
+      const double deviation = std::sqrt(variance);
+      result.dispersion += deviation;
+      if (deviation > result.maxDispersion) {
+        result.maxDispersion = deviation;
+        result.maxI = i;
+        result.maxJ = j;
+      }
+    }
+  }
+  if (n > 1) {
+    result.dispersion /= static_cast<double>(n * (n - 1) / 2);
+  }
+  result.gcci = n > 2 ? 2.0 * squares / static_cast<double>((n - 1) * (n - 2)) : std::numeric_limits<double>::quiet_NaN();
+  return result;
+}
+
+double AHP::AHPMeanCalculator::LogBlocks::distance(size_t agent, double weightSum) const {
+  if (n < 2) {
+    return 0.0;
+  }
+  // log matrices are antisymmetric, the full matrix counts every pair twice
+  const Eigen::Map<const Eigen::VectorXd> agent_logs(logs.data() + agent * n * n, n * n);
+  return std::sqrt((agent_logs - logSum / weightSum).squaredNorm() / static_cast<double>(n * (n - 1)));
+}
+
+void AHP::AHPMeanCalculator::LogBlocks::mean(double weightSum, Eigen::Ref<AHP::Matrix2D> out) const {
+  out.reshaped() = (logSum / weightSum).array().exp().matrix();
+}
+
+void AHP::AHPMeanCalculator::LogBlocks::meanWithout(size_t agent, double weight, double weightSum,
+                                                    Eigen::Ref<AHP::Matrix2D> out) const {
+  const Eigen::Map<const Eigen::VectorXd> agent_logs(logs.data() + agent * n * n, n * n);
+  out.reshaped() = ((logSum - weight * agent_logs) / (weightSum - weight)).array().exp().matrix();
+}
 
-void AHP::AHPMeanCalculator::addAltMatrices(std::map<std::string, AHP::Matrix2D>&& matrices) {
-  std::vector<AHP::Matrix2D> alt_matrices;
+size_t AHP::AHPMeanCalculator::addAgent(AHP::Matrix2D&& critMatrix, std::map<std::string, AHP::Matrix2D>&& altMatrices,
+                                        double weight) {
+  tracing::Span span("addAgent");
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
   for (auto& criterion : criteria_) {
-    alt_matrices.emplace_back(matrices.at(criterion));
+    altMatrices.at(criterion);   // all or nothing, no partially added agent
+  }
+
+  critLogs_.add(critMatrix, weight, weightSum_);
+  for (size_t i = 0; i < criteria_.size(); i++) {
+    altLogs_[i].add(altMatrices.at(criteria_[i]), weight, weightSum_);
   }
-  altMatrices_.emplace_back(alt_matrices);
+  weights_.push_back(weight);
+  weightSum_ += weight;
+
+  return weights_.size() - 1;
 }
 
-void AHP::AHPMeanCalculator::addCritMatrix(AHP::Matrix2D&& matrix) {
-  critMatrices_.emplace_back(matrix);
+void AHP::AHPMeanCalculator::setWeight(size_t agent, double weight) {
+  tracing::Span span("setWeight");
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
+
+  const double delta = weight - weights_.at(agent);
+  critLogs_.reweigh(agent, delta, weightSum_);
+  for (auto& blocks : altLogs_) {
+    blocks.reweigh(agent, delta, weightSum_);
+  }
+  weights_[agent] = weight;
+  weightSum_ += delta;
 }
 
 std::vector<std::string> AHP::AHPMeanCalculator::getCriteria() {
   return criteria_;
 }
 
-AHP::Matrix2D AHP::AHPMeanCalculator::getMeanCritMatrix() {
-  const size_t agentCount = critMatrices_.size();
-  const size_t critCount = critMatrices_[0].rows();
+size_t AHP::AHPMeanCalculator::getAgentCount() const {
+  return weights_.size();
+}
 
-  AHP::Matrix2D mean_matrix = AHP::Matrix2D::Zero(critCount, critCount);
+double AHP::AHPMeanCalculator::getWeight(size_t agent) const {
+  return weights_.at(agent);
+}
 
-  for (size_t row = 0; row < critCount; row++) {
-    for (size_t col = 0; col < critCount; col++) {
-      double product = 1.0;
-      for (size_t agentIdx = 0; agentIdx < agentCount; agentIdx++) {
-        product *= critMatrices_[agentIdx](row, col);
-      }
-      mean_matrix(row, col) = std::pow(product, 1.0/agentCount);
-    }
+void AHP::AHPMeanCalculator::checkWeightSum() const {
+  if (weights_.empty() || !(weightSum_ > 0.0)) {
+    throw std::invalid_argument("No agent with a positive weight to aggregate");
   }
+}
+
+std::vector<AHP::MatrixConsensus> AHP::AHPMeanCalculator::consensus() const {
+  tracing::Span span("consensus");
+  checkWeightSum();
+
+  std::vector<AHP::MatrixConsensus> result;
+  result.push_back(critLogs_.consensus(weightSum_));
+  for (auto& blocks : altLogs_) {
+    result.push_back(blocks.consensus(weightSum_));
+  }
+  return result;
+}
+
+Eigen::VectorXd AHP::AHPMeanCalculator::agentDistances(size_t agent) const {
+  checkWeightSum();
+  if (agent >= weights_.size()) {
+    throw std::out_of_range("No agent " + std::to_string(agent));
+  }
+
+  Eigen::VectorXd result(1 + altLogs_.size());
+  result(0) = critLogs_.distance(agent, weightSum_);
+  for (size_t i = 0; i < altLogs_.size(); i++) {
+    result(1 + i) = altLogs_[i].distance(agent, weightSum_);
+  }
+  return result;
+}
 
+AHP::Matrix2D AHP::AHPMeanCalculator::getMeanCritMatrix() {
+  checkWeightSum();
+
+  AHP::Matrix2D mean_matrix(critLogs_.n, critLogs_.n);
+  critLogs_.mean(weightSum_, mean_matrix);
   return mean_matrix;
 }
 
 std::vector<AHP::Matrix2D> AHP::AHPMeanCalculator::getMeanAltMatrices() {
-  const size_t agentCount = altMatrices_.size();
-  const size_t critCount = altMatrices_[0].size();
-  const size_t altCount = altMatrices_[0][0].rows();
-  std::vector<AHP::Matrix2D> mean_matrices;
-
-  for (size_t critIdx = 0; critIdx < critCount; critIdx++) {
-    AHP::Matrix2D mean_matrix = AHP::Matrix2D::Zero(altCount, altCount);
-
-    for (size_t row = 0; row < altCount; row++) {
-      for (size_t col = 0; col < altCount; col++) {
-        double product = 1.0;
-        for (size_t agentIdx = 0; agentIdx < agentCount; agentIdx++) {
-          product *= altMatrices_[agentIdx][critIdx](row, col);
-        }
-        mean_matrix(row, col) = std::pow(product, 1.0/agentCount);
+  checkWeightSum();
+  const Eigen::Index altCount = altLogs_[0].n;
+  std::vector<AHP::Matrix2D> mean_matrices(criteria_.size(), AHP::Matrix2D(altCount, altCount));
+
+  parallel::parallelFor(criteria_.size(), altCount * altCount, [&](Eigen::Index critIdx) {
+    altLogs_[critIdx].mean(weightSum_, mean_matrices[critIdx]);
+  });
+
+  return mean_matrices;
+}
+
+/*    AGGREGATION OF INDIVIDUAL PRIORITIES    */
+
+void AHP::AHPMeanCalculator::rankPendingAgents(AHP::PriorityMethod method) {
+  auto& cache = individual_[static_cast<size_t>(method)];
+  const size_t agentCount = weights_.size();
+  if (cache.computed == agentCount)
+    return;
+
+  tracing::Span span("rankPendingAgents");
+  const Eigen::Index critCount = critLogs_.n;
+  const Eigen::Index altCount = altLogs_[0].n;
+  if (static_cast<size_t>(cache.rankings.rows()) < agentCount) {
+    const Eigen::Index capacity = std::max<Eigen::Index>(agentCount, 2 * cache.rankings.rows());
+    cache.rankings.conservativeResize(capacity, altCount);
+    cache.logRankings.conservativeResize(capacity, altCount);
+    cache.ratios.conservativeResize(capacity, critCount + 1);
+  }
+
+  // batches share a ranker workspace; the matrices are rebuilt from the stored logs
+  constexpr size_t Batch = 16;
+  const size_t first = cache.computed;
+  const size_t batches = (agentCount - first + Batch - 1) / Batch;
+  parallel::parallelFor(batches, Batch * (critCount * critCount + critCount * altCount * altCount), [&](Eigen::Index batch) {
+    AHP::AHPRanker ranker(method);
+    AHP::RankingWorkspace ws;
+    AHP::Matrix2D critMatrix(critCount, critCount);
+    std::vector<AHP::Matrix2D> altMatrices(criteria_.size(), AHP::Matrix2D(altCount, altCount));
+
+    const size_t end = std::min(agentCount, first + (batch + 1) * Batch);
+    for (size_t agent = first + batch * Batch; agent < end; agent++) {
+      critMatrix.reshaped() = Eigen::Map<const Eigen::VectorXd>(critLogs_.logs.data() + agent * critCount * critCount,
+                                                                critCount * critCount).array().exp().matrix();
+      for (size_t i = 0; i < criteria_.size(); i++) {
+        altMatrices[i].reshaped() = Eigen::Map<const Eigen::VectorXd>(altLogs_[i].logs.data() + agent * altCount * altCount,
+                                                                      altCount * altCount).array().exp().matrix();
       }
+
+      ranker.calculateRanking(critMatrix, altMatrices, ws);
+      cache.rankings.row(agent) = ws.ranking.transpose();
+      cache.logRankings.row(agent) = ws.ranking.array().log().matrix().transpose();
+      cache.ratios(agent, 0) = ws.criteriaIRatio;
+      cache.ratios.row(agent).tail(critCount) = ws.alternativesIRatios.transpose();
     }
+  });
+  cache.computed = agentCount;
+}
 
-    mean_matrices.push_back(mean_matrix);
+AHP::AHPResult AHP::AHPMeanCalculator::getAggregatedPriorities(AHP::PriorityMethod method, AHP::AggregationMode mode) {
+  tracing::Span span("getAggregatedPriorities");
+  checkWeightSum();
+  if (mode == AggregationMode::Judgements) {
+    throw std::invalid_argument("Judgements are aggregated by getMean*, not by priorities");
+  }
+  rankPendingAgents(method);
+
+  // each alternative's column holds the agents contiguously, so both means are dot products vectorized across agents
+  const auto& cache = individual_[static_cast<size_t>(method)];
+  const Eigen::Index agentCount = weights_.size();
+  const Eigen::VectorXd weights = Eigen::Map<const Eigen::VectorXd>(weights_.data(), agentCount) / weightSum_;
+
+  Eigen::VectorXd ranking;
+  if (mode == AggregationMode::ArithmeticPriorities) {
+    ranking.noalias() = cache.rankings.topRows(agentCount).transpose() * weights;
+  } else {
+    ranking.noalias() = cache.logRankings.topRows(agentCount).transpose() * weights;
+    ranking = (ranking.array() - ranking.maxCoeff()).exp().matrix();
+    ranking /= ranking.sum();
   }
+  const Eigen::VectorXd ratios = cache.ratios.topRows(agentCount).transpose() * weights;
 
-  return mean_matrices;
+  AHP::AHPResult result;
+  result.ranking.assign(ranking.begin(), ranking.end());
+  result.criteriaIRatio = ratios(0);
+  result.alternativesIRatios.assign(ratios.begin() + 1, ratios.end());
+  return result;
 }
 
-/*    AHP RANKER    */
+/*    LEAVE-ONE-OUT INFLUENCE    */
 
-AHP::WeightsAndIR AHP::AHPRanker::calculateWeightsAndIR(AHP::Matrix2D matrix)
-{
-  const size_t n = matrix.rows();
-  Eigen::VectorXd weights = Eigen::VectorXd::Zero(n);
+namespace {
+  // Alternatives from best to worst; ties keep index order
+  void rankOrder(const Eigen::VectorXd& ranking, std::vector<Eigen::Index>& order) {
+    order.resize(ranking.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](Eigen::Index a, Eigen::Index b) { return ranking(a) > ranking(b); });
+  }
+}
 
-  for (size_t i = 0; i < n; i++) {
-    double product = 1.0;
-    for (size_t j = 0; j < n; j++) {
-      product *= matrix(i, j);
+std::vector<AHP::AgentInfluence> AHP::AHPMeanCalculator::leaveOneOut(AHP::PriorityMethod method) {
+  tracing::Span span("leaveOneOut");
+  checkWeightSum();
+  const size_t agentCount = weights_.size();
+  const Eigen::Index critCount = critLogs_.n;
+  const Eigen::Index altCount = altLogs_[0].n;
+
+  AHP::RankingWorkspace group;
+  AHP::AHPRanker(method).calculateRanking(getMeanCritMatrix(), getMeanAltMatrices(), group);
+  std::vector<Eigen::Index> groupOrder;
+  rankOrder(group.ranking, groupOrder);
+
+  // one workspace per worker, every ranking warm-started from the group's weights: no slower than from the worker's
+  // previous ranking, and unlike that start it does not depend on the schedule
+  constexpr size_t Batch = 16;
+  const size_t batches = (agentCount + Batch - 1) / Batch;
+  std::vector<AHP::AgentInfluence> influence(agentCount);
+  std::vector<AHP::RankingWorkspace> workspaces(parallel::threadCount());
+  parallel::parallelFor(batches, Batch * (critCount * critCount + critCount * altCount * altCount), [&](Eigen::Index batch) {
+    AHP::AHPRanker ranker(method);
+    AHP::RankingWorkspace& ws = workspaces[parallel::workerIndex()];
+    AHP::Matrix2D critMatrix(critCount, critCount);
+    std::vector<AHP::Matrix2D> altMatrices(criteria_.size(), AHP::Matrix2D(altCount, altCount));
+    std::vector<Eigen::Index> order;
+
+    const size_t end = std::min(agentCount, (batch + 1) * Batch);
+    for (size_t agent = batch * Batch; agent < end; agent++) {
+      const double weight = weights_[agent];
+      if (weight == 0.0) {
+        influence[agent] = {0.0, 0.0, 0};
+        continue;
+      }
+      if (!(weightSum_ - weight > 0.0)) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        influence[agent] = {nan, nan, 0};
+        continue;
+      }
+
+      critLogs_.meanWithout(agent, weight, weightSum_, critMatrix);
+      for (size_t i = 0; i < criteria_.size(); i++) {
+        altLogs_[i].meanWithout(agent, weight, weightSum_, altMatrices[i]);
+      }
+      ws.warmStartFrom(group);
+      ranker.calculateRanking(critMatrix, altMatrices, ws);
+
+      rankOrder(ws.ranking, order);
+      int moved = 0;
+      for (size_t k = 0; k < order.size(); k++) {
+        moved += order[k] != groupOrder[k];
+      }
+      influence[agent] = {(ws.ranking - group.ranking).lpNorm<1>(),
+                          (ws.criteriaWeights - group.criteriaWeights).lpNorm<1>(), moved};
+    }
+  });
+  return influence;
+}
+
+/*    BOOTSTRAP    */
+
+AHP::BootstrapResult AHP::AHPMeanCalculator::bootstrap(AHP::PriorityMethod method, size_t resamples, double confidence,
+                                                       std::uint64_t seed) {
+  tracing::Span span("bootstrap");
+  checkWeightSum();
+  if (resamples == 0) {
+    throw std::invalid_argument("Bootstrap needs at least one resample");
+  }
+  if (!(confidence > 0.0 && confidence < 1.0)) {
+    throw std::invalid_argument("Confidence must be between 0 and 1");
+  }
+  const Eigen::Index agentCount = weights_.size();
+  const Eigen::Index critCount = critLogs_.n;
+  const Eigen::Index altCount = altLogs_[0].n;
+  const Eigen::Map<const Eigen::VectorXd> weights(weights_.data(), agentCount);
+  auto logMatrix = [&](const LogBlocks& blocks) {
+    return Eigen::Map<const AHP::Matrix2D>(blocks.logs.data(), blocks.n * blocks.n, agentCount);
+  };
+
+  // one workspace per worker, every resample warm-started from the full aggregate's weights as in leaveOneOut
+  AHP::RankingWorkspace group;
+  AHP::AHPRanker(method).calculateRanking(getMeanCritMatrix(), getMeanAltMatrices(), group);
+  std::vector<AHP::RankingWorkspace> workspaces(parallel::threadCount());
+
+  constexpr Eigen::Index Batch = 64;
+  const Eigen::Index batches = (resamples + Batch - 1) / Batch;
+  AHP::Matrix2D rankings(altCount, resamples);
+  std::vector<Eigen::Index> orders(resamples * altCount);   // places of resample b at [b * altCount, (b + 1) * altCount)
+  std::vector<char> valid(resamples, 0);
+
+  const Eigen::Index cells = critCount * critCount + critCount * altCount * altCount;
+  parallel::parallelFor(batches, Batch * agentCount * cells, [&](Eigen::Index batch) {
+    const Eigen::Index first = batch * Batch;
+    const Eigen::Index count = std::min<Eigen::Index>(Batch, resamples - first);
+
+    // weighted multiplicities, agents x resamples
+    // seed_seq keeps 32 bits of each value, so the 64-bit seed goes in as two words
+    std::seed_seq streamSeed{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                             static_cast<std::uint32_t>(batch)};
+    std::mt19937_64 rng(streamSeed);
+    std::uniform_int_distribution<Eigen::Index> pickAgent(0, agentCount - 1);
+    AHP::Matrix2D multiplicities = AHP::Matrix2D::Zero(agentCount, count);
+    for (Eigen::Index b = 0; b < count; b++) {
+      for (Eigen::Index k = 0; k < agentCount; k++) {
+        multiplicities(pickAgent(rng), b) += 1.0;
+      }
     }
-    weights(i) = std::pow(product, 1.0/n);
+    multiplicities.array().colwise() *= weights.array();
+    const Eigen::RowVectorXd weightSums = multiplicities.colwise().sum();
+
+    const AHP::Matrix2D critSums = logMatrix(critLogs_) * multiplicities;
+    std::vector<AHP::Matrix2D> altSums;
+    for (auto& blocks : altLogs_) {
+      altSums.push_back(logMatrix(blocks) * multiplicities);
+    }
+
+    AHP::AHPRanker ranker(method);
+    AHP::RankingWorkspace& ws = workspaces[parallel::workerIndex()];
+    AHP::Matrix2D critMatrix(critCount, critCount);
+    std::vector<AHP::Matrix2D> altMatrices(criteria_.size(), AHP::Matrix2D(altCount, altCount));
+    std::vector<Eigen::Index> order;
+    for (Eigen::Index b = 0; b < count; b++) {
+      if (!(weightSums(b) > 0.0))
+        continue;
+      critMatrix.reshaped() = (critSums.col(b) / weightSums(b)).array().exp().matrix();
+      for (size_t i = 0; i < criteria_.size(); i++) {
+        altMatrices[i].reshaped() = (altSums[i].col(b) / weightSums(b)).array().exp().matrix();
+      }
+      ws.warmStartFrom(group);
+      ranker.calculateRanking(critMatrix, altMatrices, ws);
+
+      rankings.col(first + b) = ws.ranking;
+      rankOrder(ws.ranking, order);
+      std::copy(order.begin(), order.end(), orders.begin() + (first + b) * altCount);
+      valid[first + b] = 1;
+    }
+  });
+
+  AHP::BootstrapResult result;
+  result.rankProbabilities = AHP::Matrix2D::Zero(altCount, altCount);
+  std::vector<Eigen::Index> used;
+  for (size_t b = 0; b < resamples; b++) {
+    if (!valid[b])
+      continue;
+    used.push_back(b);
+    for (Eigen::Index place = 0; place < altCount; place++) {
+      result.rankProbabilities(orders[b * altCount + place], place) += 1.0;
+    }
+  }
+  result.resamples = used.size();
+  if (used.empty()) {
+    throw std::invalid_argument("No resample drew an agent with a positive weight");
+  }
+  result.rankProbabilities /= static_cast<double>(used.size());
+
+  // nearest-rank quantiles of each alternative's weight
+  result.lower.resize(altCount);
+  result.median.resize(altCount);
+  result.upper.resize(altCount);
+  auto quantileIndex = [&](double q) { return static_cast<size_t>(q * (used.size() - 1) + 0.5); };
+  parallel::parallelFor(altCount, used.size(), [&](Eigen::Index alt) {
+    std::vector<double> values(used.size());
+    for (size_t i = 0; i < used.size(); i++) {
+      values[i] = rankings(alt, used[i]);
+    }
+    auto at = [&](double q) {
+      std::nth_element(values.begin(), values.begin() + quantileIndex(q), values.end());
+      return values[quantileIndex(q)];
+    };
+    result.lower(alt) = at((1.0 - confidence) / 2.0);
+    result.median(alt) = at(0.5);
+    result.upper(alt) = at((1.0 + confidence) / 2.0);
+  });
+  return result;
+}
+
+/*    PRIORITY POLICIES    */
+
+namespace {
+  constexpr Eigen::Index ProductBlock = 32;   // judgements multiplied before taking a log, far from overflowing a double
+  constexpr int PowerIterationLimit = 1000;
+  constexpr double PowerIterationTolerance = 1e-10;
+
+  // Saaty's estimate of lambda max from approximate weights
+  template <typename Matrix, typename Vector>
+  double estimateLambdaMax(const Matrix& matrix, const Vector& weights, Vector& products) {
+    products.noalias() = matrix * weights;
+    return (products.array() / weights.array()).sum() / matrix.rows();
+  }
+}
+
+double AHP::consistencyRatio(double lambda_max, Eigen::Index n, AHP::PriorityMethod method) {
+  if (n <= 1)
+    return 0.0;
+
+  const double CI = (lambda_max - n) / (n - 1);
+  if (n <= static_cast<Eigen::Index>(RandomIndex.size())) {
+    return CI / RandomIndex[n-1];
   }
+  return CI / simulatedRandomIndex(n, method);
+}
 
+// Row geometric means. Fixed-size matrices are small enough for one unrolled product per row; dynamic ones multiply
+// over blocks of columns and accumulate logs, so large matrices cannot overflow.
+template <typename Matrix, typename Vector>
+double AHP::GeometricMeanPolicy::weights(const Matrix& matrix, Vector& weights, Vector& products, bool, int&) {
+  const Eigen::Index n = matrix.rows();
+  if constexpr (Matrix::RowsAtCompileTime != Eigen::Dynamic) {
+    weights = (matrix.rowwise().prod().array().log() / static_cast<double>(n)).exp().matrix();
+  } else {
+    weights.setZero();
+    for (Eigen::Index j0 = 0; j0 < n; j0 += ProductBlock) {
+      const Eigen::Index block_end = std::min(j0 + ProductBlock, n);
+      products = matrix.col(j0);
+      for (Eigen::Index j = j0 + 1; j < block_end; j++) {
+        products.array() *= matrix.col(j).array();
+      }
+      weights.array() += products.array().log();
+    }
+    weights = (weights.array() / n).exp().matrix();
+  }
   weights /= weights.sum();
 
+  return estimateLambdaMax(matrix, weights, products);
+}
+
+// Power iteration on a positive matrix converges to its Perron eigenvector; lambda max is exact at convergence.
+// The previous aggregate's eigenvector is usually a few products away, otherwise it starts from the geometric mean.
+template <typename Matrix, typename Vector>
+double AHP::EigenvectorPolicy::weights(const Matrix& matrix, Vector& weights, Vector& products, bool warm_start, int& iterations) {
+  if (!warm_start || !weights.allFinite() || (weights.array() <= 0.0).any()) {
+    GeometricMeanPolicy::weights(matrix, weights, products, false, iterations);
+  }
+
   double lambda_max = 0.0;
-  for (size_t i = 0; i < n; i++) {
-    double sum_row = 0.0;
-    for (size_t j = 0; j < n; j++) {
-      sum_row += matrix(i, j) * weights(j);
+  for (int it = 0; it < PowerIterationLimit; it++) {
+    products.noalias() = matrix * weights;
+    iterations++;
+    lambda_max = products.sum();   // A w = lambda w and sum(w) = 1
+    products /= lambda_max;
+
+    const double delta = (products - weights).cwiseAbs().maxCoeff();
+    weights = products;
+    if (delta < PowerIterationTolerance)
+      break;
+  }
+
+  return lambda_max;
+}
+
+// Row means of the column-normalized matrix, i.e. A * (1 / column sums) / n as one matrix-vector product
+template <typename Matrix, typename Vector>
+double AHP::ColumnAveragePolicy::weights(const Matrix& matrix, Vector& weights, Vector& products, bool, int&) {
+  const Eigen::Index n = matrix.rows();
+  products = matrix.colwise().sum().transpose().cwiseInverse();
+  weights.noalias() = matrix * products;
+  weights /= static_cast<double>(n);
+  weights /= weights.sum();
+
+  return estimateLambdaMax(matrix, weights, products);
+}
+
+// Minimizes sum (ln a_ij - ln w_i + ln w_j)^2; for a complete matrix the solution is the mean of each row's logs,
+// accumulated here one vectorized log per column.
+template <typename Matrix, typename Vector>
+double AHP::LogLeastSquaresPolicy::weights(const Matrix& matrix, Vector& weights, Vector& products, bool, int&) {
+  const Eigen::Index n = matrix.rows();
+  weights.setZero();
+  for (Eigen::Index j = 0; j < n; j++) {
+    weights.array() += matrix.col(j).array().log();
+  }
+  weights.array() -= weights.maxCoeff();   // scale before exp, only the ratios matter
+  weights = (weights.array() / n).exp().matrix();
+  weights /= weights.sum();
+
+  return estimateLambdaMax(matrix, weights, products);
+}
+
+/*    FIXED-SIZE DISPATCH    */
+
+namespace {
+  using WeightsFn = double (*)(AHP::MatrixRef, Eigen::Ref<Eigen::VectorXd>, bool, int&);
+
+  // Copies an N x N matrix into stack storage so the policy kernel runs with compile-time sizes
+  template <typename Policy, int N>
+  double fixedSizeWeights(AHP::MatrixRef matrix, Eigen::Ref<Eigen::VectorXd> weights, bool warm_start, int& iterations) {
+    const Eigen::Matrix<double, N, N> fixed_matrix = matrix;
+    Eigen::Matrix<double, N, 1> fixed_weights = weights;
+    Eigen::Matrix<double, N, 1> products;
+
+    const double lambda_max = Policy::weights(fixed_matrix, fixed_weights, products, warm_start, iterations);
+    weights = fixed_weights;
+    return lambda_max;
+  }
+
+  template <typename Policy, size_t... N>
+  constexpr std::array<WeightsFn, sizeof...(N)> makeFixedSizeTable(std::index_sequence<N...>) {
+    return { &fixedSizeWeights<Policy, static_cast<int>(N) + 1>... };
+  }
+
+  // FixedSizeWeights<Policy>[n-1] handles n x n matrices
+  template <typename Policy>
+  constexpr auto FixedSizeWeights = makeFixedSizeTable<Policy>(std::make_index_sequence<AHP::FixedKernelSizes>());
+  static_assert(AHP::MaxFixedSize <= AHP::FixedKernelSizes);
+  static_assert(AHP::GeometricMeanPolicy::maxFixedSize <= AHP::MaxFixedSize && AHP::EigenvectorPolicy::maxFixedSize <= AHP::MaxFixedSize &&
+                AHP::ColumnAveragePolicy::maxFixedSize <= AHP::MaxFixedSize && AHP::LogLeastSquaresPolicy::maxFixedSize <= AHP::MaxFixedSize);
+}
+
+namespace {
+  using LambdaFn = double (*)(AHP::MatrixRef, Eigen::Ref<Eigen::VectorXd>, Eigen::Ref<Eigen::VectorXd>, std::optional<bool>);
+
+  // `fixed_size` forces a path, by default the policy's cutoff picks it
+  template <typename Policy>
+  double policyLambdaMax(AHP::MatrixRef matrix, Eigen::Ref<Eigen::VectorXd> weights, Eigen::Ref<Eigen::VectorXd> products,
+                         std::optional<bool> fixed_size) {
+    int iterations = 0;
+    const Eigen::Index n = matrix.rows();
+    if (fixed_size.value_or(n <= Policy::maxFixedSize) && n >= 1 && n <= AHP::FixedKernelSizes) {
+      return FixedSizeWeights<Policy>[n-1](matrix, weights, false, iterations);
     }
-    lambda_max += sum_row / weights(i);
+    return Policy::weights(matrix, weights, products, false, iterations);
   }
-  lambda_max /= n;
 
-  double CI = (lambda_max - n) / (n - 1);
+  // indexed by PriorityMethod
+  constexpr std::array<LambdaFn, AHP::PriorityMethodCount> LambdaDispatch = {
+    &policyLambdaMax<AHP::GeometricMeanPolicy>,
+    &policyLambdaMax<AHP::EigenvectorPolicy>,
+    &policyLambdaMax<AHP::ColumnAveragePolicy>,
+    &policyLambdaMax<AHP::LogLeastSquaresPolicy>,
+  };
+}
+
+double AHP::lambdaMax(AHP::MatrixRef matrix, AHP::PriorityMethod method, Eigen::Ref<Eigen::VectorXd> weights,
+                      Eigen::Ref<Eigen::VectorXd> products) {
+  return LambdaDispatch[static_cast<size_t>(method)](matrix, weights, products, std::nullopt);
+}
 
-  const std::vector<double> RI = {0.0, 0.0, 0.58, 0.9, 1.12, 1.24, 1.32, 1.41, 1.45, 1.49};
+double AHP::kernelLambdaMax(AHP::MatrixRef matrix, AHP::PriorityMethod method, bool fixed_size,
+                            Eigen::Ref<Eigen::VectorXd> weights, Eigen::Ref<Eigen::VectorXd> products) {
+  return LambdaDispatch[static_cast<size_t>(method)](matrix, weights, products, fixed_size);
+}
+
+/*    AHP RANKER    */
 
-  double CR = 0.0;
-  if (n > 1 && n <= 10) {
-    CR = CI / RI[n-1];
+void AHP::RankingWorkspace::resize(Eigen::Index criteria, Eigen::Index alternatives) {
+  if (criteriaWeights.size() != criteria || ranking.size() != alternatives) {
+    hasWeights = false;
   }
+  criteriaWeights.resize(criteria);
+  localWeights.resize(alternatives, criteria);
+  ranking.resize(alternatives);
+  alternativesIRatios.resize(criteria);
+  scratch.resize(std::max(criteria, alternatives), criteria + 1);
+}
 
-  std::vector<double> weights_std(weights.data(), weights.data() + weights.size());
+void AHP::RankingWorkspace::warmStartFrom(const RankingWorkspace& base) {
+  criteriaWeights = base.criteriaWeights;
+  localWeights = base.localWeights;
+  hasWeights = base.hasWeights;
+}
 
-  return {weights_std, CR};
+AHP::AHPResult AHP::RankingWorkspace::result() const {
+  AHPResult result;
+  result.ranking.assign(ranking.begin(), ranking.end());
+  result.criteriaIRatio = criteriaIRatio;
+  result.alternativesIRatios.assign(alternativesIRatios.begin(), alternativesIRatios.end());
+  return result;
 }
 
-std::vector<double> AHP::AHPRanker::calculateRankingVector(AHP::Matrix2D matrix) {
-  const int alternatives = matrix.rows();
-  const int criteria = matrix.cols();
+template <typename Policy>
+double AHP::BasicAHPRanker<Policy>::calculateWeightsAndIR(AHP::MatrixRef matrix, Eigen::Ref<Eigen::VectorXd> weights,
+                                                          Eigen::Ref<Eigen::VectorXd> scratch, bool warm_start, int& iterations)
+{
+  const Eigen::Index n = matrix.rows();
 
-  Eigen::VectorXd criteriaWeights = matrix.row(0);
+  double lambda_max = 0.0;
+  if (n >= 1 && n <= Policy::maxFixedSize) {
+    lambda_max = FixedSizeWeights<Policy>[n-1](matrix, weights, warm_start, iterations);
+  } else {
+    Eigen::Ref<Eigen::VectorXd> products = scratch.head(n);
+    lambda_max = Policy::weights(matrix, weights, products, warm_start, iterations);
+  }
+  return consistencyRatio(lambda_max, n, Policy::method);
+}
+
+template <typename Policy>
+void AHP::BasicAHPRanker<Policy>::calculateRankingVector(AHP::RankingWorkspace& ws) {
+  ws.ranking.noalias() = ws.localWeights * ws.criteriaWeights;
+}
+
+template <typename Policy>
+void AHP::BasicAHPRanker<Policy>::calculateRanking(AHP::MatrixRef criteria_comparison,
+                                                   std::span<const AHP::Matrix2D> alternatives_comparisons,
+                                                   AHP::RankingWorkspace& ws) {
+  tracing::Span span("calculateRanking");
+  const Eigen::Index n_criteria = criteria_comparison.rows();
+  const Eigen::Index n_alternatives = alternatives_comparisons[0].rows();
+  ws.resize(n_criteria, n_alternatives);
+  ws.powerIterations = 0;
+  ws.unconverged = 0;
+
+  // task 0 is the criteria matrix, task i + 1 the alternatives of criterion i; each writes only its own columns.
+  // The per-matrix kernels are not traced on their own, a span costs about as much as a 10x10 kernel.
+  parallel::parallelFor(n_criteria + 1, n_alternatives * n_alternatives, [&](Eigen::Index task) {
+    int iterations = 0;
+    if (task == 0) {
+      ws.criteriaIRatio = calculateWeightsAndIR(criteria_comparison, ws.criteriaWeights, ws.scratch.col(0),
+                                                ws.hasWeights, iterations);
+    } else {
+      ws.alternativesIRatios(task - 1) = calculateWeightsAndIR(alternatives_comparisons[task - 1], ws.localWeights.col(task - 1),
+                                                               ws.scratch.col(task), ws.hasWeights, iterations);
+    }
+    std::atomic_ref(ws.powerIterations).fetch_add(iterations, std::memory_order_relaxed);
+    if (iterations >= PowerIterationLimit) {
+      std::atomic_ref(ws.unconverged).fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  calculateRankingVector(ws);
+  ws.hasWeights = true;
+}
+
+template class AHP::BasicAHPRanker<AHP::GeometricMeanPolicy>;
+template class AHP::BasicAHPRanker<AHP::EigenvectorPolicy>;
+template class AHP::BasicAHPRanker<AHP::ColumnAveragePolicy>;
+template class AHP::BasicAHPRanker<AHP::LogLeastSquaresPolicy>;
+
+namespace {
+  using RankFn = void (*)(AHP::MatrixRef, std::span<const AHP::Matrix2D>, AHP::RankingWorkspace&);
+
+  // indexed by PriorityMethod, one indirect call per ranking and none inside the kernels
+  constexpr std::array<RankFn, AHP::PriorityMethodCount> RankDispatch = {
+    &AHP::BasicAHPRanker<AHP::GeometricMeanPolicy>::calculateRanking,
+    &AHP::BasicAHPRanker<AHP::EigenvectorPolicy>::calculateRanking,
+    &AHP::BasicAHPRanker<AHP::ColumnAveragePolicy>::calculateRanking,
+    &AHP::BasicAHPRanker<AHP::LogLeastSquaresPolicy>::calculateRanking,
+  };
+}
+
+AHP::AHPRanker::AHPRanker(AHP::PriorityMethod method) : method_(method) {};
 
-  std::vector<double> ranking(alternatives - 1, 0.0);
+void AHP::AHPRanker::calculateRanking(AHP::MatrixRef criteria_comparison, std::span<const AHP::Matrix2D> alternatives_comparisons,
+                                      AHP::RankingWorkspace& ws) {
+  RankDispatch[static_cast<size_t>(method_)](criteria_comparison, alternatives_comparisons, ws);
+}
+
+AHP::AHPResult AHP::AHPRanker::calculateRanking(const AHP::Matrix2D& criteria_comparison, const std::vector<Matrix2D>& alternatives_comparisons) {
+  calculateRanking(criteria_comparison, std::span(alternatives_comparisons), workspace_);
+  return workspace_.result();
+}
+
+/*    INCOMPLETE COMPARISONS    */
+
+AHP::SparseComparisons AHP::buildSparseComparisons(const AHP::Comparisons& comparisons, const std::vector<std::string>& alternatives) {
+  tracing::Span span("buildSparseComparisons");
+  AHP::SparseComparisons sparse;
+  sparse.n = alternatives.size();
+
+  std::unordered_map<std::string, Eigen::Index> alt_idx;
+  for (size_t i = 0; i < alternatives.size(); i++) {
+    alt_idx[alternatives[i]] = i;
+  }
+
+  auto index = [&](const std::string& name) {
+    auto it = alt_idx.find(name);
+    if (it == alt_idx.end()) {
+      throw std::invalid_argument("Unknown item: " + name);
+    }
+    return it->second;
+  };
+
+  // a pair may be given in both directions, the last judgement of it wins as in buildMatrix
+  std::unordered_map<Eigen::Index, size_t> seen;
+  for (auto& [alt1, values] : comparisons) {
+    const Eigen::Index i = index(alt1);
+    for (auto& [alt2, value] : values) {
+      const Eigen::Index j = index(alt2);
+      if (i == j)
+        continue;
+      if (!std::isfinite(value) || value <= 0.0) {
+        throw std::invalid_argument("Judgements must be positive and finite: " + alt1 + " / " + alt2);
+      }
 
-  for(int i = 1; i < alternatives; i++) {
-    double sum = 0.0;
-    for(int j = 0; j < criteria; j++) {
-      sum += matrix(i, j) * criteriaWeights(j);
+      const AHP::Judgement judgement = i < j ? AHP::Judgement{i, j, value} : AHP::Judgement{j, i, 1.0 / value};
+      auto [it, inserted] = seen.try_emplace(judgement.i * sparse.n + judgement.j, sparse.judgements.size());
+      if (inserted) {
+        sparse.judgements.push_back(judgement);
+      } else {
+        sparse.judgements[it->second] = judgement;
+      }
     }
-    ranking[i-1] = sum;
   }
 
-  return ranking;
+  return sparse;
 }
 
-AHP::AHPResult AHP::AHPRanker::calculateRanking(AHP::Matrix2D criteria_comparison, std::vector<Matrix2D> alternatives_comparisons) {
-  auto [criteria_weights, criteria_ir] = calculateWeightsAndIR(criteria_comparison);
+AHP::Matrix2D AHP::toDense(const AHP::SparseComparisons& comparisons) {
+  AHP::Matrix2D matrix = AHP::Matrix2D::Ones(comparisons.n, comparisons.n);
+  for (auto& [i, j, value] : comparisons.judgements) {
+    matrix(i, j) = value;
+    matrix(j, i) = 1.0 / value;
+  }
+  return matrix;
+}
 
-  const size_t n_criteria = criteria_weights.size();
-  const size_t n_alternatives = alternatives_comparisons[0].rows();
-  Matrix2D ranking_matrix(n_alternatives + 1, n_criteria);
+AHP::SparseComparisons AHP::meanSparseComparisons(std::span<const AHP::SparseComparisons> agents, std::span<const double> weights) {
+  tracing::Span span("meanSparseComparisons");
+  AHP::SparseComparisons mean;
+  if (agents.empty())
+    return mean;
+  mean.n = agents[0].n;
+
+  struct LogMean {
+    Eigen::Index i, j;
+    double logSum = 0.0;
+    double weightSum = 0.0;
+  };
+  std::vector<LogMean> pairs;
+  std::unordered_map<Eigen::Index, size_t> pair_idx;
+  for (size_t agent = 0; agent < agents.size(); agent++) {
+    const double weight = weights[agent];
+    if (weight <= 0.0)
+      continue;
+    for (auto& [i, j, value] : agents[agent].judgements) {
+      auto [it, inserted] = pair_idx.try_emplace(i * mean.n + j, pairs.size());
+      if (inserted) {
+        pairs.push_back({i, j});
+      }
+      pairs[it->second].logSum += weight * std::log(value);
+      pairs[it->second].weightSum += weight;
+    }
+  }
 
-  for (size_t i = 0; i < n_criteria; i++) {
-    ranking_matrix(0, i) = criteria_weights[i];
+  mean.judgements.reserve(pairs.size());
+  for (auto& pair : pairs) {
+    mean.judgements.push_back({pair.i, pair.j, std::exp(pair.logSum / pair.weightSum)});
   }
+  return mean;
+}
 
-  std::vector<double> inconsistency_ratios;
-  for (size_t i = 0; i < n_criteria; i++) {
-    auto [weights, ir] = calculateWeightsAndIR(alternatives_comparisons[i]);
-    inconsistency_ratios.push_back(ir);
+bool AHP::isConnected(const AHP::SparseComparisons& comparisons) {
+  if (comparisons.n <= 1)
+    return true;
+
+  // union-find with path halving, one pass over the edges
+  std::vector<Eigen::Index> parent(comparisons.n);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](Eigen::Index x) {
+    while (parent[x] != x) {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  };
+
+  Eigen::Index components = comparisons.n;
+  for (auto& [i, j, value] : comparisons.judgements) {
+    const Eigen::Index root_i = find(i), root_j = find(j);
+    if (root_i != root_j) {
+      parent[root_i] = root_j;
+      components--;
+    }
+  }
+  return components == 1;
+}
 
-    for (size_t j = 0; j < n_alternatives; j++) {
-      ranking_matrix(j + 1, i) = weights[j];
+Eigen::VectorXd AHP::sparseLogLeastSquaresWeights(const AHP::SparseComparisons& comparisons) {
+  tracing::Span span("sparseLogLeastSquaresWeights");
+  const Eigen::Index n = comparisons.n;
+  if (n <= 1)
+    return Eigen::VectorXd::Ones(n);   // nothing to compare, and no system to ground at node 0
+  if (!isConnected(comparisons)) {
+    throw std::invalid_argument("Comparison graph is not connected, priorities are not determined");
+  }
+
+  // Normal equations of sum (ln a_ij - x_i + x_j)^2 over the judged pairs. The Laplacian is singular along the
+  // constant vector, fixing x_0 = 0 drops node 0 and leaves a positive definite system.
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(4 * comparisons.judgements.size());
+  Eigen::VectorXd b = Eigen::VectorXd::Zero(n - 1);
+  for (auto& [i, j, value] : comparisons.judgements) {
+    const double log_value = std::log(value);
+    if (i > 0) {
+      triplets.emplace_back(i - 1, i - 1, 1.0);
+      b(i - 1) += log_value;
+    }
+    if (j > 0) {
+      triplets.emplace_back(j - 1, j - 1, 1.0);
+      b(j - 1) -= log_value;
+    }
+    if (i > 0 && j > 0) {
+      triplets.emplace_back(i - 1, j - 1, -1.0);
+      triplets.emplace_back(j - 1, i - 1, -1.0);
     }
   }
 
-  std::vector<double> final_ranking = calculateRankingVector(ranking_matrix);
+  Eigen::SparseMatrix<double> laplacian(n - 1, n - 1);
+  laplacian.setFromTriplets(triplets.begin(), triplets.end());
 
-  AHPResult result;
-  result.ranking = final_ranking;
-  result.criteriaIRatio = criteria_ir;
-  result.alternativesIRatios = inconsistency_ratios;
+  Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower | Eigen::Upper> solver;
+  solver.setTolerance(1e-12);
+  solver.compute(laplacian);
+  const Eigen::VectorXd x = solver.solve(b);
+  if (solver.info() != Eigen::Success) {
+    throw std::runtime_error("Log least squares solve did not converge");
+  }
 
+  Eigen::VectorXd weights(n);
+  weights(0) = 0.0;
+  weights.tail(n - 1) = x;
+  weights = (weights.array() - weights.maxCoeff()).exp().matrix();
+  return weights / weights.sum();
+}
+
+AHP::AHPResult AHP::calculateSparseRanking(const AHP::SparseComparisons& criteria_comparison,
+                                           std::span<const AHP::SparseComparisons> alternatives_comparisons) {
+  tracing::Span span("calculateSparseRanking");
+  const Eigen::Index n_criteria = criteria_comparison.n;
+  const Eigen::Index n_alternatives = alternatives_comparisons[0].n;
+
+  Eigen::VectorXd criteria_weights;
+  AHP::Matrix2D local_weights(n_alternatives, n_criteria);
+  std::vector<double> ratios(n_criteria + 1);
+
+  // CR only exists for complete matrices; those are small in practice and checked on a dense copy
+  auto weigh = [](const AHP::SparseComparisons& comparisons, double& ratio) {
+    Eigen::VectorXd weights = sparseLogLeastSquaresWeights(comparisons);
+    ratio = std::numeric_limits<double>::quiet_NaN();
+    if (comparisons.isComplete() && comparisons.n <= MaxRandomIndexSize) {
+      const AHP::Matrix2D dense = toDense(comparisons);
+      Eigen::VectorXd products(comparisons.n);
+      ratio = consistencyRatio(estimateLambdaMax(dense, weights, products), comparisons.n, PriorityMethod::LogLeastSquares);
+    }
+    return weights;
+  };
+
+  parallel::parallelFor(n_criteria + 1, 4 * n_alternatives, [&](Eigen::Index task) {
+    if (task == 0) {
+      criteria_weights = weigh(criteria_comparison, ratios[0]);
+    } else {
+      local_weights.col(task - 1) = weigh(alternatives_comparisons[task - 1], ratios[task]);
+    }
+  });
+
+  AHP::AHPResult result;
+  const Eigen::VectorXd ranking = local_weights * criteria_weights;
+  result.ranking.assign(ranking.begin(), ranking.end());
+  result.criteriaIRatio = ratios[0];
+  result.alternativesIRatios.assign(ratios.begin() + 1, ratios.end());
   return result;
-}
\ No newline at end of file
+}
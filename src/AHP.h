@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,7 +15,23 @@ namespace AHP {
   using ComparisonValues = std::map<std::string, double>;       // alt2 -> value
   using Comparisons = std::map<std::string, ComparisonValues>;  // alt1 -> map of comaprison values for each alt2
   using Matrix2D = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
-  using WeightsAndIR = std::pair<std::vector<double>, double>;  // weights and inconsistancy ratio for a single matrix
+  using MatrixRef = Eigen::Ref<const Matrix2D>;
+
+  // How priorities are derived from a single comparison matrix
+  enum class PriorityMethod {
+    GeometricMean,    // row geometric means, lambda max estimated from them
+    Eigenvector,      // Saaty's principal eigenvector by power iteration, exact lambda max
+    ColumnAverage,    // row averages of the column-normalized matrix
+    LogLeastSquares   // logarithmic least squares fit of ln(w_i / w_j) to ln(a_ij)
+  };
+  constexpr size_t PriorityMethodCount = 4;
+
+  // How a group's submissions are combined
+  enum class AggregationMode {
+    Judgements,            // AIJ: weighted geometric mean of the agents' matrices, ranked once
+    GeometricPriorities,   // AIP: every agent ranked alone, weighted geometric mean of the rankings
+    ArithmeticPriorities   // AIP: every agent ranked alone, weighted arithmetic mean of the rankings
+  };
 
   struct AHPResult {
     std::vector<double> ranking;              // Final ranking of alternatives
@@ -20,38 +39,257 @@ namespace AHP {
     std::vector<double> alternativesIRatios;  // Inconsistency ratios for comparison of alternatives by single criterium 
   };
 
+  // Saaty's random consistency index, RI[n-1] for an n x n matrix
+  constexpr std::array<double, 10> RandomIndex = {0.0, 0.0, 0.58, 0.9, 1.12, 1.24, 1.32, 1.41, 1.45, 1.49};
+
+  // Buffers of a single ranking; reusing one across calls of the same shape makes ranking allocation-free
+  struct RankingWorkspace {
+    Eigen::VectorXd criteriaWeights;      // weights of criteria
+    Matrix2D localWeights;                // localWeights(alt, crit) - weights of alternatives within a criterion
+    Eigen::VectorXd ranking;              // final ranking of alternatives
+    Eigen::VectorXd alternativesIRatios;  // inconsistency ratio of each criterion's alternatives matrix
+    double criteriaIRatio = 0.0;
+    Matrix2D scratch;                     // matrix-vector products while computing lambda max, one column per matrix
+    bool hasWeights = false;              // weights hold the previous ranking of this shape, used to warm-start
+    int powerIterations = 0;              // matrix-vector products spent by the eigenvector method in the last ranking
+    int unconverged = 0;                  // matrices of the last ranking whose power iteration stopped at its limit
+
+    void resize(Eigen::Index criteria, Eigen::Index alternatives);   // no-op when the shape is unchanged
+    void warmStartFrom(const RankingWorkspace& base);                // the next ranking starts from base's weights
+    AHPResult result() const;
+  };
+
+  // CR of an n x n matrix whose lambda max was estimated by `method`. Saaty's RandomIndex up to n = 10, simulated
+  // indices (RandomIndex.h) above; NaN where no index is known yet, so large matrices do not pass as consistent.
+  double consistencyRatio(double lambda_max, Eigen::Index n, PriorityMethod method);
+
+  // Lambda max of `matrix` as `method` estimates it, `weights` and `products` are scratch of the matrix size
+  double lambdaMax(MatrixRef matrix, PriorityMethod method, Eigen::Ref<Eigen::VectorXd> weights, Eigen::Ref<Eigen::VectorXd> products);
+
+  // Matrices up to a policy's maxFixedSize are ranked by kernels instantiated for Eigen::Matrix<double, N, N>, the
+  // largest of those cutoffs is MaxFixedSize. Each cutoff is the last size at which the fixed kernel beat the dynamic
+  // one in ahp_bench's kernel/* cases; past it the stack copy and full unrolling cost more than the known size saves.
+  // Kernels are compiled up to FixedKernelSizes so that the crossover can be measured again.
+  constexpr Eigen::Index MaxFixedSize = 11;
+  constexpr Eigen::Index FixedKernelSizes = 16;
+
+  // lambdaMax through the fixed-size kernel (n <= FixedKernelSizes) or the dynamic one whatever the policy's cutoff,
+  // for benchmarks
+  double kernelLambdaMax(MatrixRef matrix, PriorityMethod method, bool fixed_size, Eigen::Ref<Eigen::VectorXd> weights,
+                         Eigen::Ref<Eigen::VectorXd> products);
+
+  // Priority derivation policies for BasicAHPRanker. weights() fills `weights` (summing to 1) for `matrix` and
+  // returns lambda max; `products` is scratch of the matrix size. With `warm_start` set, `weights` already holds
+  // a nearby solution, `iterations` counts matrix-vector products of iterative methods.
+  // Kernels are templates so that they are compiled both for fixed sizes up to FixedKernelSizes and for Eigen::Dynamic.
+  struct GeometricMeanPolicy {
+    static constexpr PriorityMethod method = PriorityMethod::GeometricMean;
+    static constexpr Eigen::Index maxFixedSize = 5;
+
+    template <typename Matrix, typename Vector>
+    static double weights(const Matrix& matrix, Vector& weights, Vector& products, bool warm_start, int& iterations);
+  };
+
+  struct EigenvectorPolicy {
+    static constexpr PriorityMethod method = PriorityMethod::Eigenvector;
+    static constexpr Eigen::Index maxFixedSize = 11;   // power iteration reuses the unrolled product many times
+
+    template <typename Matrix, typename Vector>
+    static double weights(const Matrix& matrix, Vector& weights, Vector& products, bool warm_start, int& iterations);
+  };
+
+  struct ColumnAveragePolicy {
+    static constexpr PriorityMethod method = PriorityMethod::ColumnAverage;
+    static constexpr Eigen::Index maxFixedSize = 10;
+
+    template <typename Matrix, typename Vector>
+    static double weights(const Matrix& matrix, Vector& weights, Vector& products, bool warm_start, int& iterations);
+  };
+
+  struct LogLeastSquaresPolicy {
+    static constexpr PriorityMethod method = PriorityMethod::LogLeastSquares;
+    static constexpr Eigen::Index maxFixedSize = 5;
+
+    template <typename Matrix, typename Vector>
+    static double weights(const Matrix& matrix, Vector& weights, Vector& products, bool warm_start, int& iterations);
+  };
+
   struct AgentInput {
     std::map<std::string, Comparisons> altComparisons;  // criteria -> comparisons of alternatives in this criteria
     Comparisons critComparisons;
+    std::map<std::string, Comparisons> subcritComparisons;  // criteria -> comparisons of its sub-criteria, hierarchies only
+    double weight = 1.0;                                // expert weight in the group aggregation
   };
 
 
   Matrix2D buildMatrix(const Comparisons& comparisons, const std::vector<std::string>& alternatives);
 
+  // Single judgement a_ij = value, with i < j
+  struct Judgement {
+    Eigen::Index i;
+    Eigen::Index j;
+    double value;
+  };
+
+  // Incomplete comparison matrix as the edge list of its comparison graph, every unordered pair at most once
+  struct SparseComparisons {
+    Eigen::Index n = 0;
+    std::vector<Judgement> judgements;
+
+    bool isComplete() const { return static_cast<Eigen::Index>(judgements.size()) == n * (n - 1) / 2; }
+  };
+
+  // throws std::invalid_argument for unknown items and judgements that are not positive and finite
+  SparseComparisons buildSparseComparisons(const Comparisons& comparisons, const std::vector<std::string>& alternatives);
+  Matrix2D toDense(const SparseComparisons& comparisons);   // missing pairs become 1.0, as in buildMatrix
+
+  // Group judgement of every pair compared by an agent of positive weight, weighted geometric mean over the agents that
+  // compared it; `weights` holds one expert weight per agent
+  SparseComparisons meanSparseComparisons(std::span<const SparseComparisons> agents, std::span<const double> weights);
+
+  bool isConnected(const SparseComparisons& comparisons);   // priorities are only determined on a connected graph
+
+  // Logarithmic least squares priorities of an incomplete matrix: the graph Laplacian system L ln(w) = b, grounded
+  // at node 0 and solved by conjugate gradient. Throws std::invalid_argument if the graph is not connected.
+  Eigen::VectorXd sparseLogLeastSquaresWeights(const SparseComparisons& comparisons);
+
+  // Ranking from incomplete matrices; inconsistency ratios are NaN for matrices with missing pairs
+  AHPResult calculateSparseRanking(const SparseComparisons& criteria_comparison,
+                                   std::span<const SparseComparisons> alternatives_comparisons);
+
+  // Change of the group result if one agent's submission were left out
+  struct AgentInfluence {
+    double rankingShift;    // L1 distance between the ranking without the agent and the group ranking
+    double criteriaShift;   // L1 distance between the criteria weights without the agent and the group's
+    int positionChanges;    // alternatives whose place in the ranking changes
+  };
+
+  // Distribution of the group ranking over bootstrap resamples of the agents
+  struct BootstrapResult {
+    size_t resamples = 0;          // resamples used; draws of zero-weight agents only are skipped
+    Eigen::VectorXd lower;         // per alternative, weight quantiles at (1 - confidence) / 2, 1/2 and (1 + confidence) / 2
+    Eigen::VectorXd median;
+    Eigen::VectorXd upper;
+    Matrix2D rankProbabilities;    // (alternative, place): share of resamples ranking the alternative there, best first
+  };
+
+  // Agreement of the panel on one comparison matrix
+  struct MatrixConsensus {
+    double gcci;              // geometric cardinal consensus index, the weighted mean GCI of the agents' matrices against
+                              // the group's row geometric mean priorities; NaN below three items
+    double dispersion;        // weighted standard deviation of ln a_ij over the agents, averaged over the pairs i < j
+    double maxDispersion;     // largest of those deviations, of the pair (maxI, maxJ); maxI == maxJ for a single item
+    Eigen::Index maxI = 0, maxJ = 0;
+  };
+
+  // Weighted geometric mean of the agents' matrices, exp(sum_k w_k ln A_k / sum_k w_k). The weighted log sums are
+  // kept up to date, so adding an agent or changing an expert weight costs O(criteria * n^2) and reading the mean
+  // never touches the individual agents.
   class AHPMeanCalculator {
   public:
     AHPMeanCalculator(const std::vector<std::string>& criteria);
 
-    void addAltMatrices(std::map<std::string, Matrix2D>&& matrices);
-    void addCritMatrix(Matrix2D&& matrix);
+    // returns the agent's index; throws std::out_of_range if a criterion's matrix is missing
+    size_t addAgent(Matrix2D&& critMatrix, std::map<std::string, Matrix2D>&& altMatrices, double weight = 1.0);
+    void setWeight(size_t agent, double weight);   // throws std::invalid_argument for negative or non-finite weights
 
     std::vector<std::string> getCriteria();   // returns criteria names
+    size_t getAgentCount() const;
+    double getWeight(size_t agent) const;
 
     Matrix2D getMeanCritMatrix();                // returns geometric mean matrix for criteria comparison
-    std::vector<Matrix2D> getMeanAltMatrices();  // returns geometric mean matrices for each criteria
+    std::vector<Matrix2D> getMeanAltMatrices();  // returns geometric mean matrices for each criteria, in parallel over criteria
+
+    // AIP: combines the agents' individual rankings under `method` (mode must not be Judgements). Inconsistency ratios
+    // are the weighted means of the individual ones. Rankings are cached per method, so only agents added since the
+    // last call are ranked, in parallel batches; the combination itself is one pass over alternatives x agents.
+    AHPResult getAggregatedPriorities(PriorityMethod method, AggregationMode mode);
+
+    // Leave-one-out influence of every agent on the judgement aggregate ranked by `method`. Each agent's weighted logs
+    // are subtracted from the sums rather than reaggregating the others, so the analysis costs O(agents * criteria * n^2)
+    // plus one ranking per agent, in parallel over agents. NaN shifts where no positive weight would remain.
+    std::vector<AgentInfluence> leaveOneOut(PriorityMethod method);
+
+    // Resamples the agents with replacement `resamples` times and ranks every judgement aggregate by `method`.
+    // A resample is a multiplicity vector over the agents, so the log sums of a batch of resamples are one matrix
+    // product with the agents' logs; batches run in parallel, each with its own RNG stream derived from `seed`,
+    // and the result does not depend on the thread count. Each worker reuses one workspace, warm-started from the full
+    // aggregate's weights for every resample.
+    BootstrapResult bootstrap(PriorityMethod method, size_t resamples, double confidence = 0.95, std::uint64_t seed = 1);
+
+    // Consensus on every matrix, criteria first. The weighted second central moment of every log judgement is kept next
+    // to the log sums (West's weighted form of Welford's update, so expert weights can change), which makes a read
+    // O(criteria * n^2) whatever the number of agents.
+    std::vector<MatrixConsensus> consensus() const;
+    // RMS distance of the agent's log judgements to the group's mean ones over the pairs i < j, per matrix, criteria first
+    Eigen::VectorXd agentDistances(size_t agent) const;
+
+  private:
+    // ln of one comparison matrix for every agent; agent k's n * n cells are contiguous at [k * n * n, (k + 1) * n * n)
+    struct LogBlocks {
+      Eigen::Index n = 0;
+      std::vector<double> logs;
+      Eigen::VectorXd logSum;   // sum_k w_k ln A_k, column-major n * n
+      Eigen::VectorXd logM2;    // sum_k w_k (ln A_k - mean)^2
+
+      // weightSum is the agents' weight before the change
+      void add(const Matrix2D& matrix, double weight, double weightSum);
+      void reweigh(size_t agent, double delta, double weightSum);   // adds delta * ln A_agent
+      MatrixConsensus consensus(double weightSum) const;
+      double distance(size_t agent, double weightSum) const;
+      void mean(double weightSum, Eigen::Ref<Matrix2D> out) const;
+      void meanWithout(size_t agent, double weight, double weightSum, Eigen::Ref<Matrix2D> out) const;
+    };
+
+    // Individual results of every agent under one priority method, one row per agent
+    struct IndividualRankings {
+      Matrix2D rankings;   // capacity x alternatives
+      Matrix2D logRankings;
+      Matrix2D ratios;     // capacity x (1 + criteria), criteria CR first
+      size_t computed = 0;
+    };
+
+    void checkWeightSum() const;
+    void rankPendingAgents(PriorityMethod method);
+
+    LogBlocks critLogs_;
+    std::vector<LogBlocks> altLogs_;   // altLogs_[criteriaIdx]
+    std::vector<double> weights_;      // weights_[agentIdx]
+    double weightSum_ = 0.0;
+    std::vector<std::string> criteria_;   // criteria names
+    std::array<IndividualRankings, PriorityMethodCount> individual_;
+  };
+
+  // Ranker with the priority method fixed at compile time; instantiated in AHP.cpp for the policies above
+  template <typename Policy>
+  class BasicAHPRanker {
+  public:
+    // Writes everything into the caller-owned workspace, no heap allocations once the workspace has the right shape.
+    // The criteria matrix and every alternatives matrix are independent and are weighted in parallel when large enough.
+    static void calculateRanking(MatrixRef criteria_comparison, std::span<const Matrix2D> alternatives_comparisons, RankingWorkspace& ws);
 
   private:
-    std::vector<std::vector<Matrix2D>> altMatrices_;    // altMatrices_[agentIdx][criteriaIdx]
-    std::vector<Matrix2D> critMatrices_;                // vector of criteria comparison matrices
-    std::vector<std::string> criteria_;                 // criteria names
+    // returns CR; with warm_start iterative methods start from the weights already in `weights`
+    static double calculateWeightsAndIR(MatrixRef matrix, Eigen::Ref<Eigen::VectorXd> weights, Eigen::Ref<Eigen::VectorXd> scratch,
+                                        bool warm_start, int& iterations);
+    static void calculateRankingVector(RankingWorkspace& ws);
   };
 
+  extern template class BasicAHPRanker<GeometricMeanPolicy>;
+  extern template class BasicAHPRanker<EigenvectorPolicy>;
+  extern template class BasicAHPRanker<ColumnAveragePolicy>;
+  extern template class BasicAHPRanker<LogLeastSquaresPolicy>;
+
+  // Picks the BasicAHPRanker instantiation at runtime through a dispatch table
   class AHPRanker {
   public:
-    AHPResult calculateRanking(Matrix2D criteria_comparison, std::vector<Matrix2D> alternatives_comparisons);
-      
+    explicit AHPRanker(PriorityMethod method = PriorityMethod::GeometricMean);
+
+    AHPResult calculateRanking(const Matrix2D& criteria_comparison, const std::vector<Matrix2D>& alternatives_comparisons);
+    void calculateRanking(MatrixRef criteria_comparison, std::span<const Matrix2D> alternatives_comparisons, RankingWorkspace& ws);
+
   private:
-    WeightsAndIR calculateWeightsAndIR(Matrix2D matrix);
-    std::vector<double> calculateRankingVector(Matrix2D matrix);
+    PriorityMethod method_;
+    RankingWorkspace workspace_;   // backs the AHPResult overload
   };
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "ANP.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+  constexpr int MaxPeriod = 32;                // longest cycle limitPriorities detects
+  constexpr Eigen::Index LimitRowBlock = 1024;  // rows of one parallel task of the matrix-vector product
+
+  // Priorities and CR (NaN where no random index is known, 0 up to two items) of every block, in parallel over blocks
+  void blockWeights(const std::vector<AHP::NetworkBlock>& blocks, AHP::PriorityMethod method,
+                    std::vector<Eigen::VectorXd>& weights, std::vector<double>& ratios) {
+    weights.resize(blocks.size());
+    ratios.assign(blocks.size(), 0.0);
+    Eigen::Index cells = 0;
+    for (auto& block : blocks) {
+      cells += block.matrix.size();
+    }
+    const Eigen::Index perBlock = blocks.empty() ? 0 : cells / static_cast<Eigen::Index>(blocks.size()) + 1;
+    parallel::parallelFor(blocks.size(), perBlock, [&](Eigen::Index b) {
+      const AHP::Matrix2D& matrix = blocks[b].matrix;
+      weights[b].resize(matrix.rows());
+      Eigen::VectorXd products(matrix.rows());
+      const double lambda = AHP::lambdaMax(matrix, method, weights[b], products);
+      if (matrix.rows() > 2) {
+        ratios[b] = AHP::consistencyRatio(lambda, matrix.rows(), method);
+      }
+    });
+  }
+
+  void checkBlock(const AHP::NetworkBlock& block, Eigen::Index controls, Eigen::Index items) {
+    const Eigen::Index n = static_cast<Eigen::Index>(block.compared.size());
+    if (block.control < 0 || block.control >= controls || n == 0 || block.matrix.rows() != n || block.matrix.cols() != n) {
+      throw std::invalid_argument("Malformed network comparison block");
+    }
+    for (Eigen::Index item : block.compared) {
+      if (item < 0 || item >= items) {
+        throw std::invalid_argument("Network comparison block compares an unknown item");
+      }
+    }
+  }
+}
+
+AHP::NetworkModel AHP::buildNetworkModel(const std::vector<std::pair<std::string, std::vector<std::string>>>& clusters,
+                                         const std::map<std::string, std::map<std::string, AHP::Comparisons>>& node_comparisons,
+                                         const std::map<std::string, AHP::Comparisons>& cluster_comparisons) {
+  tracing::Span span("buildNetworkModel");
+  NetworkModel model;
+  model.clusterBegin.push_back(0);
+  for (auto& [cluster, nodes] : clusters) {
+    model.clusters.push_back(cluster);
+    model.nodes.insert(model.nodes.end(), nodes.begin(), nodes.end());
+    model.clusterBegin.push_back(static_cast<Eigen::Index>(model.nodes.size()));
+  }
+
+  auto index = [](const std::vector<std::string>& items, const std::string& name, Eigen::Index begin, Eigen::Index end) {
+    auto it = std::find(items.begin() + begin, items.begin() + end, name);
+    if (it == items.begin() + end) {
+      throw std::invalid_argument("Unknown network item: " + name);
+    }
+    return static_cast<Eigen::Index>(it - items.begin());
+  };
+  // the items a matrix mentions, in model order, as a complete matrix of their comparisons
+  auto block = [&](const std::vector<std::string>& items, Eigen::Index begin, Eigen::Index end,
+                   const AHP::Comparisons& comparisons, Eigen::Index control) {
+    NetworkBlock result{control, {}, {}};
+    for (auto& [item, values] : comparisons) {
+      result.compared.push_back(index(items, item, begin, end));
+      for (auto& value : values) {
+        result.compared.push_back(index(items, value.first, begin, end));
+      }
+    }
+    std::sort(result.compared.begin(), result.compared.end());
+    result.compared.erase(std::unique(result.compared.begin(), result.compared.end()), result.compared.end());
+    std::vector<std::string> names;
+    for (Eigen::Index item : result.compared) {
+      names.push_back(items[item]);
+    }
+    const SparseComparisons sparse = buildSparseComparisons(comparisons, names);
+    if (!sparse.isComplete()) {
+      throw std::invalid_argument("Network matrices must be complete: " + items[control]);
+    }
+    result.matrix = toDense(sparse);
+    return result;
+  };
+
+  const Eigen::Index nodeCount = static_cast<Eigen::Index>(model.nodes.size());
+  const Eigen::Index clusterCount = static_cast<Eigen::Index>(model.clusters.size());
+  for (auto& [node, byCluster] : node_comparisons) {
+    const Eigen::Index control = index(model.nodes, node, 0, nodeCount);
+    for (auto& [cluster, comparisons] : byCluster) {
+      const Eigen::Index c = index(model.clusters, cluster, 0, clusterCount);
+      model.nodeBlocks.push_back(block(model.nodes, model.clusterBegin[c], model.clusterBegin[c + 1], comparisons, control));
+    }
+  }
+  for (auto& [cluster, comparisons] : cluster_comparisons) {
+    const Eigen::Index control = index(model.clusters, cluster, 0, clusterCount);
+    model.clusterBlocks.push_back(block(model.clusters, 0, clusterCount, comparisons, control));
+  }
+  return model;
+}
+
+Eigen::Index AHP::NetworkModel::clusterOf(Eigen::Index node) const {
+  return std::upper_bound(clusterBegin.begin(), clusterBegin.end(), node) - clusterBegin.begin() - 1;
+}
+
+AHP::Supermatrix AHP::buildSupermatrix(const AHP::NetworkModel& model, AHP::PriorityMethod method) {
+  tracing::Span span("buildSupermatrix");
+  const Eigen::Index n = static_cast<Eigen::Index>(model.nodes.size());
+  const Eigen::Index clusters = static_cast<Eigen::Index>(model.clusters.size());
+  if (static_cast<Eigen::Index>(model.clusterBegin.size()) != clusters + 1 || model.clusterBegin.front() != 0 ||
+      model.clusterBegin.back() != n || !std::is_sorted(model.clusterBegin.begin(), model.clusterBegin.end())) {
+    throw std::invalid_argument("Network clusters do not partition its nodes");
+  }
+
+  // validated up front, pool workers must not throw
+  std::unordered_set<Eigen::Index> seen;
+  for (auto& block : model.nodeBlocks) {
+    checkBlock(block, n, n);
+    const Eigen::Index cluster = model.clusterOf(block.compared.front());
+    for (Eigen::Index node : block.compared) {
+      if (model.clusterOf(node) != cluster) {
+        throw std::invalid_argument("Nodes compared in one block must share a cluster");
+      }
+    }
+    if (!seen.insert(block.control * clusters + cluster).second) {
+      throw std::invalid_argument("Two blocks compare the same cluster with respect to " + model.nodes[block.control]);
+    }
+  }
+  seen.clear();
+  for (auto& block : model.clusterBlocks) {
+    checkBlock(block, clusters, clusters);
+    if (!seen.insert(block.control).second) {
+      throw std::invalid_argument("Two blocks compare the clusters with respect to " + model.clusters[block.control]);
+    }
+  }
+
+  std::vector<Eigen::VectorXd> nodeWeights, clusterWeightsOf;
+  std::vector<double> nodeRatios, clusterRatios;
+  blockWeights(model.nodeBlocks, method, nodeWeights, nodeRatios);
+  blockWeights(model.clusterBlocks, method, clusterWeightsOf, clusterRatios);
+
+  // clusterWeights(C, D): weight of cluster C's block in the columns of cluster D
+  Matrix2D clusterWeights = Matrix2D::Ones(clusters, clusters);
+  for (size_t b = 0; b < model.clusterBlocks.size(); b++) {
+    auto& block = model.clusterBlocks[b];
+    clusterWeights.col(block.control).setZero();
+    for (size_t k = 0; k < block.compared.size(); k++) {
+      clusterWeights(block.compared[k], block.control) = clusterWeightsOf[b](k);
+    }
+  }
+
+  Eigen::VectorXd columnSums = Eigen::VectorXd::Zero(n);
+  size_t entries = 0;
+  for (auto& block : model.nodeBlocks) {
+    columnSums(block.control) += clusterWeights(model.clusterOf(block.compared.front()), model.clusterOf(block.control));
+    entries += block.compared.size();
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(entries + n);
+  for (size_t b = 0; b < model.nodeBlocks.size(); b++) {
+    auto& block = model.nodeBlocks[b];
+    const double sum = columnSums(block.control);
+    if (!(sum > 0.0))
+      continue;
+    const double scale = clusterWeights(model.clusterOf(block.compared.front()), model.clusterOf(block.control)) / sum;
+    for (size_t k = 0; k < block.compared.size(); k++) {
+      triplets.emplace_back(block.compared[k], block.control, scale * nodeWeights[b](k));
+    }
+  }
+  // a node depending on nothing keeps its weight, so the matrix stays column stochastic
+  for (Eigen::Index j = 0; j < n; j++) {
+    if (!(columnSums(j) > 0.0)) {
+      triplets.emplace_back(j, j, 1.0);
+    }
+  }
+
+  Supermatrix result;
+  result.weighted.resize(n, n);
+  result.weighted.setFromTriplets(triplets.begin(), triplets.end());
+  for (const auto* ratios : {&nodeRatios, &clusterRatios}) {
+    for (double ratio : *ratios) {
+      // an unknown CR must not pass as consistent
+      result.maxIRatio = std::isnan(ratio) || std::isnan(result.maxIRatio) ? std::numeric_limits<double>::quiet_NaN()
+                                                                             : std::max(result.maxIRatio, ratio);
+    }
+  }
+  return result;
+}
+
+AHP::LimitPriorities AHP::limitPriorities(const AHP::SparseSupermatrix& weighted, double tolerance, int max_iterations) {
+  tracing::Span span("limitPriorities");
+  const Eigen::Index n = weighted.rows();
+  if (weighted.cols() != n) {
+    throw std::invalid_argument("Supermatrix must be square");
+  }
+  LimitPriorities result;
+  if (n == 0) {
+    result.period = 1;
+    return result;
+  }
+
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(n, 1.0 / n), y(n);
+  Matrix2D history(n, MaxPeriod);   // iterate k in column k % MaxPeriod
+  history.col(0) = x;
+  const Eigen::Index blocks = (n + LimitRowBlock - 1) / LimitRowBlock;
+  const Eigen::Index cellsPerBlock = weighted.nonZeros() / blocks + 1;
+
+  auto finish = [&](int iterates, int period) {
+    result.priorities = Eigen::VectorXd::Zero(n);
+    for (int q = 0; q < iterates; q++) {
+      result.priorities += history.col((result.iterations - q) % MaxPeriod);
+    }
+    result.priorities /= result.priorities.sum();
+    result.period = period;
+    return result;
+  };
+
+  for (int k = 1; k <= max_iterations; k++) {
+    parallel::parallelFor(blocks, cellsPerBlock, [&](Eigen::Index b) {
+      const Eigen::Index begin = b * LimitRowBlock;
+      const Eigen::Index rows = std::min(LimitRowBlock, n - begin);
+      y.segment(begin, rows) = weighted.middleRows(begin, rows) * x;
+    });
+    x.swap(y);
+    result.iterations = k;
+
+    // converged (period 1) or cycling: the iterate repeats the one `period` steps back
+    for (int period = 1; period <= std::min(k, MaxPeriod); period++) {
+      if ((x - history.col((k - period) % MaxPeriod)).lpNorm<1>() < tolerance) {
+        history.col(k % MaxPeriod) = x;
+        return finish(period, period);
+      }
+    }
+    history.col(k % MaxPeriod) = x;
+  }
+
+  // no cycle found, the mean of the last iterates is the best estimate
+  return finish(std::min(max_iterations + 1, MaxPeriod), 0);
+}
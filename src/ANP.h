@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <Eigen/SparseCore>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Analytic network process: nodes grouped into clusters may depend on nodes of any cluster, their own included, so
+// feedback between clusters is allowed. Every dependency is a pairwise matrix of some nodes of one cluster with
+// respect to one node; its priorities fill that node's column of the supermatrix, the cluster blocks are weighted by
+// comparisons of the clusters with respect to the node's cluster, and the limit of the weighted (column stochastic)
+// supermatrix's powers gives the priorities of all nodes.
+namespace AHP {
+  // Pairwise comparisons of `compared` with respect to `control`; n x n matrix for n compared items
+  struct NetworkBlock {
+    Eigen::Index control;
+    std::vector<Eigen::Index> compared;
+    Matrix2D matrix;
+  };
+
+  struct NetworkModel {
+    std::vector<std::string> clusters;
+    std::vector<std::string> nodes;            // grouped by cluster
+    std::vector<Eigen::Index> clusterBegin;    // cluster c holds nodes [clusterBegin[c], clusterBegin[c + 1]), one entry past the last
+    std::vector<NetworkBlock> nodeBlocks;      // control and compared are nodes, the compared ones from a single cluster
+    std::vector<NetworkBlock> clusterBlocks;   // control and compared are clusters
+
+    Eigen::Index clusterOf(Eigen::Index node) const;
+  };
+
+  // Model from named judgements: the clusters in order with their nodes, node -> cluster -> comparisons of that
+  // cluster's nodes with respect to the node, and cluster -> comparisons of clusters with respect to it. Only the items
+  // a matrix mentions are compared, the rest get no weight in its control's column. Throws for unknown names and
+  // incomplete matrices.
+  NetworkModel buildNetworkModel(const std::vector<std::pair<std::string, std::vector<std::string>>>& clusters,
+                                 const std::map<std::string, std::map<std::string, Comparisons>>& node_comparisons,
+                                 const std::map<std::string, Comparisons>& cluster_comparisons);
+
+  using SparseSupermatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+  struct Supermatrix {
+    SparseSupermatrix weighted;   // column stochastic, column j holds what node j depends on
+    double maxIRatio = 0.0;       // largest CR of the node and cluster matrices with more than two items
+  };
+
+  // Priorities of every block by `method`, cluster weighted and normalized per column. Clusters a node's cluster has
+  // no comparisons for weigh equally, clusters left out of its comparisons do not count, and a node depending on
+  // nothing keeps its weight (a one on the diagonal). Throws std::invalid_argument for malformed or duplicate blocks.
+  Supermatrix buildSupermatrix(const NetworkModel& model, PriorityMethod method);
+
+  struct LimitPriorities {
+    Eigen::VectorXd priorities;   // per node, summing to 1
+    int iterations = 0;           // sparse matrix-vector products
+    int period = 0;               // length of the cycle the powers settled into, 1 when they converge; 0 if not converged
+  };
+
+  // Limit of W^k applied to the uniform vector, by the power method: one sparse matrix-vector product per step, in
+  // parallel over row blocks, so a step costs O(nonzeros). Periodic networks cycle instead of converging; once the
+  // iterate is within `tolerance` (L1) of the one `period` steps earlier, the limit is the mean over the cycle, the
+  // Cesaro limit of the powers. Reducible networks converge to the column mean of the limit supermatrix.
+  LimitPriorities limitPriorities(const SparseSupermatrix& weighted, double tolerance = 1e-10, int max_iterations = 10000);
+}
@@ -0,0 +1,135 @@
+#include "Diagnostics.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace {
+  constexpr Eigen::Index PanelRows = 64;   // rows of one parallel task of the triad sweep
+
+  struct Scored {
+    double score;   // sum of squared triad logs over the triad count
+    Eigen::Index i, j;
+  };
+
+  bool worse(const Scored& a, const Scored& b) {
+    return a.score > b.score || (a.score == b.score && (a.i < b.i || (a.i == b.i && a.j < b.j)));
+  }
+
+  // the `top` worst of `scored`, worst first
+  void keepWorst(std::vector<Scored>& scored, size_t top) {
+    const size_t keep = std::min(top, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + keep, scored.end(), worse);
+    scored.resize(keep);
+  }
+}
+
+AHP::ConsistencyDiagnostics AHP::diagnoseConsistency(AHP::MatrixRef matrix, AHP::PriorityMethod method, size_t top,
+                                                     Eigen::Index samples, std::uint64_t seed) {
+  tracing::Span span("diagnoseConsistency");
+  const Eigen::Index n = matrix.rows();
+  if (matrix.cols() != n) {
+    throw std::invalid_argument("Comparison matrix must be square");
+  }
+  if (!(matrix.array() > 0.0).all() || !matrix.allFinite()) {
+    throw std::invalid_argument("Judgements must be positive and finite");
+  }
+
+  ConsistencyDiagnostics result;
+  Eigen::VectorXd weights(n), products(n);
+  const double lambda = lambdaMax(matrix, method, weights, products);
+  if (n <= 2) {
+    return result;
+  }
+  result.iRatio = consistencyRatio(lambda, n, method);
+
+  // third items k, all of them or a sample drawn without replacement
+  const Matrix2D logs = matrix.array().log().matrix();
+  std::vector<Eigen::Index> thirds(n);
+  std::iota(thirds.begin(), thirds.end(), 0);
+  if (samples > 0 && samples < n) {
+    std::mt19937_64 rng(seed);
+    for (Eigen::Index k = 0; k < samples; k++) {
+      std::swap(thirds[k], thirds[std::uniform_int_distribution<Eigen::Index>(k, n - 1)(rng)]);
+    }
+    thirds.resize(samples);
+    std::sort(thirds.begin(), thirds.end());
+  }
+  const Eigen::Index m = static_cast<Eigen::Index>(thirds.size());
+  result.thirdItems = m;
+  const Matrix2D sampled = m == n ? logs : Matrix2D(logs(Eigen::all, thirds));
+  std::vector<char> isThird(n, 0);
+  for (Eigen::Index k : thirds) {
+    isThird[k] = 1;
+  }
+  const Eigen::VectorXd squares = sampled.rowwise().squaredNorm();
+  const Eigen::VectorXd sums = sampled.rowwise().sum();
+
+  // sum over k of (L_ij + L_jk - L_ik)^2 = m L_ij^2 + q_i + q_j + 2 L_ij (s_j - s_i) - 2 (L L^T)_ij, the triads with
+  // k = i or k = j vanish. Each panel takes the upper triangle of its rows and keeps its own worst judgements.
+  const Eigen::Index panels = (n + PanelRows - 1) / PanelRows;
+  std::vector<std::vector<Scored>> worst(panels);
+  parallel::parallelFor(panels, PanelRows * n * m, [&](Eigen::Index p) {
+    const Eigen::Index begin = p * PanelRows;
+    const Eigen::Index rows = std::min(PanelRows, n - begin);
+    const Matrix2D gram = sampled.middleRows(begin, rows) * sampled.middleRows(begin, n - begin).transpose();
+    std::vector<Scored>& scored = worst[p];
+    for (Eigen::Index r = 0; r < rows; r++) {
+      const Eigen::Index i = begin + r;
+      for (Eigen::Index j = i + 1; j < n; j++) {
+        const double a = logs(i, j);
+        const double sum = m * a * a + squares(i) + squares(j) + 2.0 * a * (sums(j) - sums(i)) - 2.0 * gram(r, j - begin);
+        const Eigen::Index triads = m - isThird[i] - isThird[j];
+        scored.push_back({triads > 0 ? std::max(sum, 0.0) / triads : 0.0, i, j});
+      }
+    }
+    keepWorst(scored, top);
+  });
+  std::vector<Scored> merged;
+  for (auto& scored : worst) {
+    merged.insert(merged.end(), scored.begin(), scored.end());
+  }
+  keepWorst(merged, top);
+
+  // every third item for the reported judgements, O(n) each
+  const Eigen::VectorXd rowSums = logs.rowwise().sum();
+  for (auto& [score, i, j] : merged) {
+    JudgementDiagnosis diagnosis{i, j, matrix(i, j), std::sqrt(score), -1, 1.0, 1.0};
+    double worstLog = -1.0;
+    for (Eigen::Index k = 0; k < n; k++) {
+      if (k == i || k == j)
+        continue;
+      const double triad = logs(i, j) + logs(j, k) - logs(i, k);
+      if (std::abs(triad) > worstLog) {
+        worstLog = std::abs(triad);
+        diagnosis.worstThird = k;
+        diagnosis.worstTriad = std::exp(triad);
+      }
+    }
+    // sum over k != i, j of L_ik - L_jk, from the row sums
+    diagnosis.suggested = std::exp((rowSums(i) - rowSums(j) - 2.0 * logs(i, j)) / static_cast<double>(n - 2));
+    result.judgements.push_back(diagnosis);
+  }
+
+  // CR only orders matrices of one size through lambda max, which stays comparable where no random index is known
+  Matrix2D fixed = matrix;
+  double bestLambda = lambda;
+  for (size_t c = 0; c < result.judgements.size(); c++) {
+    const auto& diagnosis = result.judgements[c];
+    fixed(diagnosis.i, diagnosis.j) = diagnosis.suggested;
+    fixed(diagnosis.j, diagnosis.i) = 1.0 / diagnosis.suggested;
+    const double fixedLambda = lambdaMax(fixed, method, weights, products);
+    if (fixedLambda < bestLambda) {
+      bestLambda = fixedLambda;
+      result.bestFix = c;
+    }
+    fixed(diagnosis.i, diagnosis.j) = matrix(diagnosis.i, diagnosis.j);
+    fixed(diagnosis.j, diagnosis.i) = matrix(diagnosis.j, diagnosis.i);
+  }
+  result.fixedIRatio = result.bestFix ? consistencyRatio(bestLambda, n, method) : result.iRatio;
+  return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Consistency diagnostics of one comparison matrix: which judgements the triads (i, j, k) disagree with most and the
+// single change that helps the CR most, so respondents can fix their input rather than resubmit blindly.
+namespace AHP {
+  // Matrices above this size are diagnosed from a sample of third items unless the caller asks otherwise
+  constexpr Eigen::Index ExactTriadsUpTo = 500;
+  constexpr Eigen::Index TriadSamples = 128;
+
+  struct JudgementDiagnosis {
+    Eigen::Index i, j;          // i < j
+    double value;               // a_ij
+    double inconsistency;       // RMS of ln(a_ij a_jk / a_ik) over the triads of the judgement, 0 when consistent
+    Eigen::Index worstThird;    // k of the judgement's most inconsistent triad
+    double worstTriad;          // a_ij a_jk / a_ik of that triad
+    double suggested;           // geometric mean of the indirect judgements a_ik a_kj, k != i, j
+  };
+
+  struct ConsistencyDiagnostics {
+    std::vector<JudgementDiagnosis> judgements;   // most inconsistent first
+    double iRatio = 0.0;                          // CR of the matrix, NaN where no random index is known
+    std::optional<size_t> bestFix;                // judgement whose suggested value lowers lambda max the most, if any does
+    double fixedIRatio = 0.0;                     // CR once bestFix is applied
+    Eigen::Index thirdItems = 0;                  // third items k the triads were taken over, n when not sampled
+  };
+
+  // Scores every judgement by its triads and returns the `top` worst. Sum over k of ln(a_ij a_jk / a_ik)^2 expands into
+  // row sums and the Gram matrix of ln A, so the O(n^3) sweep is one blocked matrix product over row panels in
+  // parallel. With 0 < `samples` < n only that many random third items (drawn from `seed`) enter the scores, O(n^2
+  // samples); worst triads and suggestions still use all of them. The best fix is searched among the reported
+  // judgements, each candidate costing one lambda max. Throws std::invalid_argument for non-positive judgements.
+  ConsistencyDiagnostics diagnoseConsistency(MatrixRef matrix, PriorityMethod method, size_t top,
+                                             Eigen::Index samples = 0, std::uint64_t seed = 0);
+}
@@ -0,0 +1,164 @@
+#include "Fuzzy.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+  constexpr double ScaleMax = 9.0;
+  constexpr double ScaleSlack = 0.01;   // in ln, admits rounded reciprocals such as 0.111 for 1/9
+
+  // ln of the bounds of a judgement a_ij >= 1, i < j; its reciprocal a_ji gets the negated bounds swapped
+  void fuzzyLogs(double value, double spread, double& lower, double& modal, double& upper) {
+    if (value == 1.0) {
+      upper = std::log(std::min(ScaleMax, 1.0 + spread));
+      lower = -upper;
+      modal = 0.0;
+    } else if (value > 1.0) {
+      lower = std::log(std::max(1.0, value - spread));
+      modal = std::log(value);
+      upper = std::log(std::min(ScaleMax, value + spread));
+    } else {
+      fuzzyLogs(1.0 / value, spread, upper, modal, lower);
+      lower = -lower;
+      modal = -modal;
+      upper = -upper;
+    }
+  }
+
+  // The bounds are clamped to the scale, a judgement beyond it would get a modal value outside its own bounds
+  bool onScale(const AHP::Matrix2D& matrix) {
+    for (Eigen::Index j = 1; j < matrix.cols(); j++) {
+      for (Eigen::Index i = 0; i < j; i++) {
+        if (!(std::abs(std::log(matrix(i, j))) <= std::log(ScaleMax) + ScaleSlack))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Buckley's weights of fuzzy row geometric means r: w_l = r_l / sum r_u, w_m = r_m / sum r_m, w_u = r_u / sum r_l
+  AHP::TriangularWeights buckleyWeights(const Eigen::ArrayXd& lower, const Eigen::ArrayXd& modal, const Eigen::ArrayXd& upper) {
+    return {lower / upper.sum(), modal / modal.sum(), upper / lower.sum()};
+  }
+}
+
+void AHP::FuzzyMeanCalculator::FuzzyLogs::add(const AHP::Matrix2D& matrix, double spread, double weight) {
+  const Eigen::Index cells = n * n;
+  const size_t offset = logs.size();
+  logs.resize(offset + 3 * cells);
+  Eigen::Map<Eigen::VectorXd> agentLogs(logs.data() + offset, 3 * cells);
+  Eigen::Map<AHP::Matrix2D> lower(logs.data() + offset, n, n), modal(logs.data() + offset + cells, n, n),
+    upper(logs.data() + offset + 2 * cells, n, n);
+  lower.diagonal().setZero();
+  modal.diagonal().setZero();
+  upper.diagonal().setZero();
+  for (Eigen::Index j = 1; j < n; j++) {
+    for (Eigen::Index i = 0; i < j; i++) {
+      fuzzyLogs(matrix(i, j), spread, lower(i, j), modal(i, j), upper(i, j));
+      lower(j, i) = -upper(i, j);
+      modal(j, i) = -modal(i, j);
+      upper(j, i) = -lower(i, j);
+    }
+  }
+  logSum += weight * agentLogs;
+}
+
+void AHP::FuzzyMeanCalculator::FuzzyLogs::reweigh(size_t agent, double delta) {
+  logSum += delta * Eigen::Map<const Eigen::VectorXd>(logs.data() + agent * 3 * n * n, 3 * n * n);
+}
+
+AHP::TriangularWeights AHP::FuzzyMeanCalculator::FuzzyLogs::weights(double weightSum) const {
+  // the row geometric mean of the group bound matrix is exp of the row mean of its log sum over the weight sum
+  const Eigen::Index cells = n * n;
+  auto rowMean = [&](Eigen::Index bound) -> Eigen::ArrayXd {
+    const Eigen::Map<const AHP::Matrix2D> sums(logSum.data() + bound * cells, n, n);
+    return (sums.rowwise().sum() / (n * weightSum)).array().exp();
+  };
+  return buckleyWeights(rowMean(0), rowMean(1), rowMean(2));
+}
+
+AHP::FuzzyMeanCalculator::FuzzyMeanCalculator(Eigen::Index criteria, Eigen::Index alternatives, double spread)
+  : spread_(spread), altLogs_(criteria) {
+  if (!std::isfinite(spread) || spread <= 0.0) {
+    throw std::invalid_argument("Fuzzy spread must be positive");
+  }
+  critLogs_.n = criteria;
+  critLogs_.logSum = Eigen::VectorXd::Zero(3 * criteria * criteria);
+  for (auto& logs : altLogs_) {
+    logs.n = alternatives;
+    logs.logSum = Eigen::VectorXd::Zero(3 * alternatives * alternatives);
+  }
+}
+
+size_t AHP::FuzzyMeanCalculator::addAgent(const AHP::Matrix2D& critMatrix, std::span<const AHP::Matrix2D> altMatrices,
+                                          double weight) {
+  tracing::Span span("FuzzyMeanCalculator::addAgent");
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
+  if (altMatrices.size() != altLogs_.size() || critMatrix.rows() != critLogs_.n || critMatrix.cols() != critLogs_.n) {
+    throw std::invalid_argument("Expected one criteria matrix and one matrix per criterion");
+  }
+  for (size_t c = 0; c < altLogs_.size(); c++) {
+    if (altMatrices[c].rows() != altLogs_[c].n || altMatrices[c].cols() != altLogs_[c].n) {
+      throw std::invalid_argument("Comparison matrix size differs from the survey");
+    }
+  }
+  if (!onScale(critMatrix) || !std::all_of(altMatrices.begin(), altMatrices.end(), onScale)) {
+    throw std::invalid_argument("Fuzzy judgements must lie between 1/9 and 9");
+  }
+
+  critLogs_.add(critMatrix, spread_, weight);
+  for (size_t c = 0; c < altLogs_.size(); c++) {
+    altLogs_[c].add(altMatrices[c], spread_, weight);
+  }
+  weights_.push_back(weight);
+  weightSum_ += weight;
+  return weights_.size() - 1;
+}
+
+void AHP::FuzzyMeanCalculator::setWeight(size_t agent, double weight) {
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
+
+  const double delta = weight - weights_.at(agent);
+  critLogs_.reweigh(agent, delta);
+  for (auto& logs : altLogs_) {
+    logs.reweigh(agent, delta);
+  }
+  weights_[agent] = weight;
+  weightSum_ += delta;
+}
+
+AHP::FuzzyResult AHP::FuzzyMeanCalculator::rank() const {
+  tracing::Span span("FuzzyMeanCalculator::rank");
+  if (!(weightSum_ > 0.0)) {
+    throw std::invalid_argument("Fuzzy ranking needs an agent of positive weight");
+  }
+
+  const Eigen::Index criteria = static_cast<Eigen::Index>(altLogs_.size());
+  const Eigen::Index alternatives = altLogs_.empty() ? 0 : altLogs_[0].n;
+  FuzzyResult result;
+  result.criteria = critLogs_.weights(weightSum_);
+
+  // local fuzzy weights, one column per criterion
+  AHP::Matrix2D lower(alternatives, criteria), modal(alternatives, criteria), upper(alternatives, criteria);
+  parallel::parallelFor(criteria, 3 * alternatives * alternatives, [&](Eigen::Index c) {
+    const AHP::TriangularWeights local = altLogs_[c].weights(weightSum_);
+    lower.col(c) = local.lower;
+    modal.col(c) = local.modal;
+    upper.col(c) = local.upper;
+  });
+
+  // fuzzy products and sums bound by bound, all bounds are positive
+  result.ranking.lower = lower * result.criteria.lower;
+  result.ranking.modal = modal * result.criteria.modal;
+  result.ranking.upper = upper * result.criteria.upper;
+  result.defuzzified = result.ranking.lower + result.ranking.modal + result.ranking.upper;
+  result.defuzzified /= result.defuzzified.sum();
+  return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <span>
+#include <vector>
+
+// Fuzzy AHP with triangular fuzzy numbers (l, m, u). Every crisp judgement a > 1 becomes (a - s, a, a + s) within
+// [1, 9] for the survey's spread s, a = 1 becomes (1 / (1 + s), 1, 1 + s) and judgements below 1 the reciprocals of
+// those, so every fuzzy matrix stays reciprocal. The group matrix is the weighted geometric mean of each bound and the
+// weights follow Buckley's geometric mean method.
+namespace AHP {
+  struct TriangularWeights {
+    Eigen::VectorXd lower, modal, upper;
+  };
+
+  struct FuzzyResult {
+    TriangularWeights criteria;   // fuzzy criteria weights
+    TriangularWeights ranking;    // fuzzy global scores of the alternatives
+    Eigen::VectorXd defuzzified;  // centroid (l + m + u) / 3 of the scores, normalized to sum 1
+  };
+
+  // Fuzzy counterpart of AHPMeanCalculator. An agent's three bound matrices are stored as a structure of arrays,
+  // the n * n logs of the lower, modal and upper bounds back to back, so adding or reweighing an agent is the one
+  // weighted log-sum kernel over 3 n^2 contiguous values and costs about three crisp aggregations.
+  class FuzzyMeanCalculator {
+  public:
+    FuzzyMeanCalculator(Eigen::Index criteria, Eigen::Index alternatives, double spread);
+
+    // one complete reciprocal matrix per criterion, judgements within [1/9, 9] or std::invalid_argument is thrown
+    // before anything changes; returns the agent's index
+    size_t addAgent(const Matrix2D& critMatrix, std::span<const Matrix2D> altMatrices, double weight = 1.0);
+    void setWeight(size_t agent, double weight);   // throws std::invalid_argument for negative or non-finite weights
+
+    double spread() const { return spread_; }
+
+    // Buckley's row geometric means read straight off the log sums, no fuzzy matrix is materialized
+    FuzzyResult rank() const;
+
+  private:
+    // Agent k's [ln L | ln M | ln U] at [3 k n^2, 3 (k + 1) n^2), each bound column-major
+    struct FuzzyLogs {
+      Eigen::Index n = 0;
+      std::vector<double> logs;
+      Eigen::VectorXd logSum;   // sum_k w_k [ln L_k | ln M_k | ln U_k]
+
+      void add(const Matrix2D& matrix, double spread, double weight);   // matrix of size n, checked by the caller
+      void reweigh(size_t agent, double delta);
+      TriangularWeights weights(double weightSum) const;
+    };
+
+    double spread_;
+    FuzzyLogs critLogs_;
+    std::vector<FuzzyLogs> altLogs_;
+    std::vector<double> weights_;
+    double weightSum_ = 0.0;
+  };
+}
@@ -0,0 +1,253 @@
+#include "Hierarchy.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+AHP::CriteriaHierarchy::CriteriaHierarchy(const std::vector<std::string>& top,
+                                          const std::map<std::string, std::vector<std::string>>& children) {
+  tracing::Span span("CriteriaHierarchy");
+  if (top.empty()) {
+    throw std::invalid_argument("A criteria hierarchy needs at least one criterion");
+  }
+
+  // breadth-first, a node's children are appended together when it is reached
+  names_.push_back("");
+  parent_.push_back(-1);
+  std::unordered_set<std::string> seen;
+  size_t parents = 0;
+  for (size_t v = 0; v < names_.size(); v++) {
+    const std::vector<std::string>* kids = &top;
+    if (v > 0) {
+      auto it = children.find(names_[v]);
+      kids = it == children.end() ? nullptr : &it->second;
+      if (kids) {
+        parents++;
+        if (kids->empty()) {
+          throw std::invalid_argument("Criterion without sub-criteria: " + names_[v]);
+        }
+      }
+    }
+    firstChild_.push_back(static_cast<Eigen::Index>(names_.size()));
+    childCount_.push_back(kids ? static_cast<Eigen::Index>(kids->size()) : 0);
+    if (!kids)
+      continue;
+    innerNodes_.push_back(v);
+    for (auto& kid : *kids) {
+      if (kid.empty() || !seen.insert(kid).second) {
+        throw std::invalid_argument("Criterion named twice or unnamed: " + kid);
+      }
+      names_.push_back(kid);
+      parent_.push_back(v);
+    }
+  }
+  if (parents != children.size()) {
+    throw std::invalid_argument("Sub-criteria of a criterion outside the hierarchy");
+  }
+
+  // children have larger numbers than their parents, so a reverse pass sees every subtree before its root
+  const size_t nodes = names_.size();
+  leafCount_.assign(nodes, 0);
+  for (size_t v = nodes; v-- > 0;) {
+    if (childCount_[v] == 0) {
+      leafCount_[v] = 1;
+    }
+    if (v > 0) {
+      leafCount_[parent_[v]] += leafCount_[v];
+    }
+  }
+  leafBegin_.assign(nodes, 0);
+  subtreeOffset_.assign(nodes, -1);
+  leaves_.resize(leafCount_[0]);
+  Eigen::Index offset = 0;
+  for (size_t v = 0; v < nodes; v++) {
+    if (childCount_[v] == 0) {
+      leaves_[leafBegin_[v]] = names_[v];
+      continue;
+    }
+    subtreeOffset_[v] = offset;
+    offset += leafCount_[v];
+    Eigen::Index begin = leafBegin_[v];
+    for (Eigen::Index c = firstChild_[v]; c < firstChild_[v] + childCount_[v]; c++) {
+      leafBegin_[c] = begin;
+      begin += leafCount_[c];
+    }
+  }
+
+  local_ = Eigen::VectorXd::Ones(nodes);
+  for (Eigen::Index v : innerNodes_) {
+    local_.segment(firstChild_[v], childCount_[v]).setConstant(1.0 / childCount_[v]);
+  }
+  subtree_ = Eigen::VectorXd::Zero(offset);
+  dirty_.assign(nodes, 1);
+}
+
+Eigen::Index AHP::CriteriaHierarchy::node(const std::string& name) const {
+  auto it = std::find(names_.begin() + 1, names_.end(), name);
+  if (it == names_.end()) {
+    throw std::invalid_argument("Unknown criterion: " + name);
+  }
+  return it - names_.begin();
+}
+
+std::vector<std::string> AHP::CriteriaHierarchy::childNames(Eigen::Index node) const {
+  return {names_.begin() + firstChild_[node], names_.begin() + firstChild_[node] + childCount_[node]};
+}
+
+void AHP::CriteriaHierarchy::setLocalWeights(Eigen::Index node, Eigen::Ref<const Eigen::VectorXd> weights) {
+  if (weights.size() != childCount_[node] || childCount_[node] == 0) {
+    throw std::invalid_argument("Expected one local weight per sub-criterion of " + names_[node]);
+  }
+  local_.segment(firstChild_[node], childCount_[node]) = weights;
+  // ancestors of a marked node are marked already
+  for (Eigen::Index v = node; v >= 0 && !dirty_[v]; v = parent_[v]) {
+    dirty_[v] = 1;
+  }
+}
+
+Eigen::Ref<const Eigen::VectorXd> AHP::CriteriaHierarchy::localWeights(Eigen::Index node) const {
+  return local_.segment(firstChild_[node], childCount_[node]);
+}
+
+Eigen::Ref<const Eigen::VectorXd> AHP::CriteriaHierarchy::globalWeights() {
+  recomputed_ = 0;
+  for (auto it = innerNodes_.rbegin(); it != innerNodes_.rend(); ++it) {
+    const Eigen::Index v = *it;
+    if (!dirty_[v])
+      continue;
+    // a child's slice of this node's leaves is its local weight times its own cached subtree
+    for (Eigen::Index c = firstChild_[v]; c < firstChild_[v] + childCount_[v]; c++) {
+      const Eigen::Index at = subtreeOffset_[v] + leafBegin_[c] - leafBegin_[v];
+      if (childCount_[c] == 0) {
+        subtree_(at) = local_(c);
+      } else {
+        subtree_.segment(at, leafCount_[c]) = local_(c) * subtree_.segment(subtreeOffset_[c], leafCount_[c]);
+      }
+    }
+    dirty_[v] = 0;
+    recomputed_++;
+  }
+  return subtree_.head(leafCount_[0]);
+}
+
+std::map<Eigen::Index, AHP::Matrix2D> AHP::buildNodeMatrices(const AHP::CriteriaHierarchy& hierarchy, const AHP::Comparisons& top,
+                                                             const std::map<std::string, AHP::Comparisons>& sub) {
+  std::map<Eigen::Index, AHP::Matrix2D> matrices;
+  auto add = [&](Eigen::Index node, const AHP::Comparisons& comparisons) {
+    if (comparisons.empty())
+      return;
+    if (hierarchy.childCount(node) == 0) {
+      throw std::invalid_argument("Criterion without sub-criteria: " + hierarchy.name(node));
+    }
+    const AHP::SparseComparisons sparse = AHP::buildSparseComparisons(comparisons, hierarchy.childNames(node));
+    if (!sparse.isComplete()) {
+      throw std::invalid_argument("Sub-criteria matrices must be complete: " + hierarchy.name(node));
+    }
+    matrices[node] = AHP::toDense(sparse);
+  };
+  add(0, top);
+  for (auto& [parent, comparisons] : sub) {
+    add(hierarchy.node(parent), comparisons);
+  }
+  return matrices;
+}
+
+AHP::HierarchyMeanCalculator::HierarchyMeanCalculator(AHP::CriteriaHierarchy hierarchy)
+  : hierarchy_(std::move(hierarchy)), nodes_(hierarchy_.nodeCount()) {
+  for (Eigen::Index v : hierarchy_.innerNodes()) {
+    nodes_[v].n = hierarchy_.childCount(v);
+    nodes_[v].logSum = Eigen::VectorXd::Zero(nodes_[v].n * nodes_[v].n);
+  }
+}
+
+size_t AHP::HierarchyMeanCalculator::addAgent(std::map<Eigen::Index, AHP::Matrix2D>&& nodeMatrices, double weight) {
+  tracing::Span span("HierarchyMeanCalculator::addAgent");
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
+  for (auto& [v, matrix] : nodeMatrices) {
+    if (v < 0 || v >= hierarchy_.nodeCount() || matrix.rows() != nodes_[v].n || matrix.cols() != nodes_[v].n || nodes_[v].n == 0) {
+      throw std::invalid_argument("Sub-criteria matrix does not match the hierarchy");
+    }
+  }
+
+  const size_t agent = weights_.size();
+  for (auto& [v, matrix] : nodeMatrices) {
+    auto& node = nodes_[v];
+    const Eigen::Index cells = node.n * node.n;
+    const size_t offset = node.logs.size();
+    node.logs.resize(offset + cells);
+    Eigen::Map<Eigen::VectorXd> agentLogs(node.logs.data() + offset, cells);
+    agentLogs = matrix.reshaped().array().log();
+    node.logSum += weight * agentLogs;
+    node.weightSum += weight;
+    node.agents.push_back(agent);
+    node.stale = true;
+  }
+  weights_.push_back(weight);
+  return agent;
+}
+
+void AHP::HierarchyMeanCalculator::setWeight(size_t agent, double weight) {
+  if (!std::isfinite(weight) || weight < 0.0) {
+    throw std::invalid_argument("Agent weight must be finite and non-negative");
+  }
+
+  const double delta = weight - weights_.at(agent);
+  for (Eigen::Index v : hierarchy_.innerNodes()) {
+    auto& node = nodes_[v];
+    auto it = std::lower_bound(node.agents.begin(), node.agents.end(), agent);
+    if (it == node.agents.end() || *it != agent)
+      continue;
+    const Eigen::Index cells = node.n * node.n;
+    node.logSum += delta * Eigen::Map<const Eigen::VectorXd>(node.logs.data() + (it - node.agents.begin()) * cells, cells);
+    node.weightSum += delta;
+    node.stale = true;
+  }
+  weights_[agent] = weight;
+}
+
+void AHP::HierarchyMeanCalculator::rankStaleNodes(AHP::PriorityMethod method) {
+  tracing::Span span("HierarchyMeanCalculator::rankStaleNodes");
+  const bool all = rankedWith_ != method;
+  rankedWith_.reset();
+  for (Eigen::Index v : hierarchy_.innerNodes()) {
+    auto& node = nodes_[v];
+    if (!node.stale && !all)
+      continue;
+    Eigen::VectorXd weights = Eigen::VectorXd::Constant(node.n, 1.0 / node.n);
+    node.ratio = 0.0;
+    if (node.weightSum > 0.0) {
+      Matrix2D mean(node.n, node.n);
+      mean.reshaped() = (node.logSum / node.weightSum).array().exp().matrix();
+      Eigen::VectorXd products(node.n);
+      const double lambda = lambdaMax(mean, method, weights, products);
+      if (node.n > 2) {
+        node.ratio = consistencyRatio(lambda, node.n, method);
+      }
+    }
+    hierarchy_.setLocalWeights(v, weights);
+    node.stale = false;
+  }
+  rankedWith_ = method;
+}
+
+Eigen::Ref<const Eigen::VectorXd> AHP::HierarchyMeanCalculator::criteriaWeights(AHP::PriorityMethod method) {
+  rankStaleNodes(method);
+  return hierarchy_.globalWeights();
+}
+
+double AHP::HierarchyMeanCalculator::criteriaIRatio(AHP::PriorityMethod method) {
+  rankStaleNodes(method);
+  double ratio = 0.0;
+  for (Eigen::Index v : hierarchy_.innerNodes()) {
+    // an unknown CR (no random index for the size) must not pass as consistent
+    if (std::isnan(nodes_[v].ratio))
+      return std::numeric_limits<double>::quiet_NaN();
+    ratio = std::max(ratio, nodes_[v].ratio);
+  }
+  return ratio;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Criteria with sub-criteria to any depth. Alternatives are compared under the leaves only; every inner node has its
+// own comparison matrix of its children, and a leaf's global weight is the product of the local weights on its path.
+namespace AHP {
+  // The tree compiled into flat arrays. Nodes are numbered breadth-first from the goal (node 0), so the children of a
+  // node are contiguous and all local weights live in one vector, a node's local weight vector being the slice of its
+  // children. Leaves are numbered depth-first, so every subtree covers a contiguous range of leaves. Each inner node
+  // caches the leaf weights of its subtree relative to itself; setting a node's local weights marks its path to the
+  // goal, and globalWeights() recomputes only the marked nodes, children before parents, in one reverse pass.
+  class CriteriaHierarchy {
+  public:
+    // `top` are the goal's children, `children` maps a criterion to its sub-criteria. Throws std::invalid_argument
+    // for names used twice, parents outside the tree and empty sub-criteria lists.
+    CriteriaHierarchy(const std::vector<std::string>& top, const std::map<std::string, std::vector<std::string>>& children);
+
+    Eigen::Index nodeCount() const { return static_cast<Eigen::Index>(names_.size()); }
+    Eigen::Index node(const std::string& name) const;   // throws std::invalid_argument for unknown names
+    const std::string& name(Eigen::Index node) const { return names_[node]; }
+    Eigen::Index parent(Eigen::Index node) const { return parent_[node]; }   // -1 for the goal
+    Eigen::Index childCount(Eigen::Index node) const { return childCount_[node]; }
+    std::vector<std::string> childNames(Eigen::Index node) const;
+    const std::vector<Eigen::Index>& innerNodes() const { return innerNodes_; }   // breadth-first, the goal first
+    const std::vector<std::string>& leaves() const { return leaves_; }              // depth-first
+
+    // Weights of the node's children within it, summing to 1; the goal's children start out equal
+    void setLocalWeights(Eigen::Index node, Eigen::Ref<const Eigen::VectorXd> weights);
+    Eigen::Ref<const Eigen::VectorXd> localWeights(Eigen::Index node) const;
+
+    Eigen::Ref<const Eigen::VectorXd> globalWeights();   // per leaf, recomputes the marked paths
+    Eigen::Index recomputedNodes() const { return recomputed_; }   // inner nodes recomputed by the last globalWeights()
+
+  private:
+    std::vector<std::string> names_;
+    std::vector<Eigen::Index> parent_;
+    std::vector<Eigen::Index> firstChild_, childCount_;
+    std::vector<Eigen::Index> leafBegin_, leafCount_;   // leaves covered by the node's subtree
+    std::vector<Eigen::Index> subtreeOffset_;           // inner nodes: start of their cached leaf weights in subtree_
+    std::vector<Eigen::Index> innerNodes_;
+    std::vector<std::string> leaves_;
+    Eigen::VectorXd local_;     // local_(c): weight of node c within its parent, 1 for the goal
+    Eigen::VectorXd subtree_;   // per inner node, the leaf weights of its subtree; the goal's come first
+    std::vector<char> dirty_;
+    Eigen::Index recomputed_ = 0;
+  };
+
+  // One agent's matrices per inner node, from the goal's comparisons (`top`) and the sub-criteria comparisons keyed
+  // by parent. Nodes without judgements are left out; throws for unknown names and incomplete matrices.
+  std::map<Eigen::Index, Matrix2D> buildNodeMatrices(const CriteriaHierarchy& hierarchy, const Comparisons& top,
+                                                     const std::map<std::string, Comparisons>& sub);
+
+  // Weighted geometric mean of the agents' matrices at every inner node, over the agents that judged the node. Adding
+  // an agent or changing its weight only marks the nodes it judged, and criteriaWeights() reranks just those, so a
+  // submission touching one branch recomputes that branch's path to the goal.
+  class HierarchyMeanCalculator {
+  public:
+    explicit HierarchyMeanCalculator(CriteriaHierarchy hierarchy);
+
+    size_t addAgent(std::map<Eigen::Index, Matrix2D>&& nodeMatrices, double weight = 1.0);   // returns the agent's index
+    void setWeight(size_t agent, double weight);   // throws std::invalid_argument for negative or non-finite weights
+
+    const CriteriaHierarchy& hierarchy() const { return hierarchy_; }
+
+    // Global leaf weights under `method`; nodes nobody judged weigh their children equally
+    Eigen::Ref<const Eigen::VectorXd> criteriaWeights(PriorityMethod method);
+    double criteriaIRatio(PriorityMethod method);   // largest CR over the inner nodes with more than two children
+
+  private:
+    // Weighted log sums of one inner node's matrices; agents in submission order, their n * n logs contiguous
+    struct NodeLogs {
+      Eigen::Index n = 0;
+      std::vector<size_t> agents;
+      std::vector<double> logs;
+      Eigen::VectorXd logSum;
+      double weightSum = 0.0;
+      double ratio = 0.0;
+      bool stale = true;
+    };
+
+    void rankStaleNodes(PriorityMethod method);
+
+    CriteriaHierarchy hierarchy_;
+    std::vector<NodeLogs> nodes_;   // by node index, empty for leaves
+    std::vector<double> weights_;
+    std::optional<PriorityMethod> rankedWith_;
+  };
+}
@@ -0,0 +1,142 @@
+#include "QuestionSelector.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+  constexpr int FiedlerIterationLimit = 200;     // per suggestion; warm-started, one new edge needs only a few
+  constexpr double FiedlerTolerance = 1e-6;      // on the residual |L f - lambda_2 f|, relative to the shift
+}
+
+AHP::QuestionSelector::QuestionSelector(Eigen::Index n)
+  : n_(n), neighbours_(n), parent_(n), componentSize_(n, 1), components_(n), order_(n) {
+  std::iota(parent_.begin(), parent_.end(), 0);
+  std::iota(order_.begin(), order_.end(), 0);
+}
+
+Eigen::Index AHP::QuestionSelector::find(Eigen::Index x) {
+  while (parent_[x] != x) {
+    parent_[x] = parent_[parent_[x]];
+    x = parent_[x];
+  }
+  return x;
+}
+
+bool AHP::QuestionSelector::isJudged(Eigen::Index i, Eigen::Index j) const {
+  return judged_.contains(std::min(i, j) * n_ + std::max(i, j));
+}
+
+void AHP::QuestionSelector::addJudgement(Eigen::Index i, Eigen::Index j) {
+  if (i == j || !judged_.insert(std::min(i, j) * n_ + std::max(i, j)).second)
+    return;
+
+  neighbours_[i].push_back(j);
+  neighbours_[j].push_back(i);
+  maxDegree_ = std::max({maxDegree_, static_cast<Eigen::Index>(neighbours_[i].size()),
+                         static_cast<Eigen::Index>(neighbours_[j].size())});
+
+  Eigen::Index root_i = find(i), root_j = find(j);
+  if (root_i != root_j) {
+    if (componentSize_[root_i] < componentSize_[root_j])
+      std::swap(root_i, root_j);
+    parent_[root_j] = root_i;
+    componentSize_[root_i] += componentSize_[root_j];
+    components_--;
+  }
+}
+
+std::optional<AHP::QuestionSelector::Pair> AHP::QuestionSelector::next() {
+  tracing::Span span("nextQuestion");
+  if (static_cast<Eigen::Index>(judged_.size()) == n_ * (n_ - 1) / 2)
+    return std::nullopt;
+
+  if (components_ > 1) {
+    lambda2_ = 0.0;
+    return joinComponents();
+  }
+
+  refineFiedlerVector();
+  return widestUnjudgedPair();
+}
+
+// The least-judged node of the smallest component against the least-judged node outside it
+AHP::QuestionSelector::Pair AHP::QuestionSelector::joinComponents() {
+  Eigen::Index smallest = -1;
+  for (Eigen::Index x = 0; x < n_; x++) {
+    const Eigen::Index root = find(x);
+    if (smallest < 0 || componentSize_[root] < componentSize_[smallest])
+      smallest = root;
+  }
+
+  Eigen::Index inside = -1, outside = -1;
+  for (Eigen::Index x = 0; x < n_; x++) {
+    Eigen::Index& best = find(x) == smallest ? inside : outside;
+    if (best < 0 || neighbours_[x].size() < neighbours_[best].size())
+      best = x;
+  }
+  return {std::min(inside, outside), std::max(inside, outside)};
+}
+
+// Power iteration on (c I - L) restricted to the complement of the constant vector, whose dominant eigenvector is
+// the Fiedler vector for c >= lambda_max(L); 2 * max degree bounds it. Iterates until the eigen-residual is small,
+// starting from the previous suggestion's vector.
+void AHP::QuestionSelector::refineFiedlerVector() {
+  if (fiedler_.size() != n_) {
+    fiedler_ = Eigen::VectorXd::LinSpaced(n_, -1.0, 1.0);   // any start not orthogonal to f works
+    product_.resize(n_);
+  }
+
+  const double shift = 2.0 * maxDegree_ + 1.0;
+  double laplacian_quotient = 0.0;
+  for (int it = 0; it < FiedlerIterationLimit; it++) {
+    fiedler_.array() -= fiedler_.mean();
+    fiedler_.normalize();
+
+    laplacian_quotient = 0.0;
+    for (Eigen::Index x = 0; x < n_; x++) {
+      double lx = static_cast<double>(neighbours_[x].size()) * fiedler_(x);
+      for (Eigen::Index y : neighbours_[x]) {
+        lx -= fiedler_(y);
+      }
+      laplacian_quotient += fiedler_(x) * lx;
+      product_(x) = shift * fiedler_(x) - lx;
+    }
+
+    // f has unit norm and zero mean, so L f - q f = (c - q) f - product
+    const double residual = ((shift - laplacian_quotient) * fiedler_ - product_).norm();
+    if (residual < FiedlerTolerance * shift)
+      break;
+    product_.array() -= product_.mean();
+    product_.normalize();
+    fiedler_.swap(product_);
+  }
+  lambda2_ = laplacian_quotient;
+}
+
+// Scans nodes from the low end of f against the high end, skipping judged pairs; each scan stops at the first unjudged
+// partner, so the search costs O(n log n) for the sort plus O(judgements)
+AHP::QuestionSelector::Pair AHP::QuestionSelector::widestUnjudgedPair() {
+  std::sort(order_.begin(), order_.end(), [&](Eigen::Index a, Eigen::Index b) { return fiedler_(a) < fiedler_(b); });
+
+  Pair best{-1, -1};
+  double best_gap = -1.0;
+  for (Eigen::Index lo = 0; lo < n_ - 1; lo++) {
+    const Eigen::Index low = order_[lo];
+    if (fiedler_(order_[n_ - 1]) - fiedler_(low) <= best_gap)
+      break;
+
+    for (Eigen::Index hi = n_ - 1; hi > lo; hi--) {
+      const Eigen::Index high = order_[hi];
+      if (isJudged(low, high))
+        continue;
+      const double gap = fiedler_(high) - fiedler_(low);
+      if (gap > best_gap) {
+        best_gap = gap;
+        best = {std::min(low, high), std::max(low, high)};
+      }
+      break;
+    }
+  }
+  return best;
+}
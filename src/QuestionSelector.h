@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace AHP {
+  // Suggests which pair of an n x n comparison matrix to ask a respondent next, growing the comparison graph one
+  // judgement at a time. While the graph is disconnected it joins the two smallest components; once connected it picks
+  // the unjudged pair (i, j) maximizing (f_i - f_j)^2 for the Fiedler vector f, the edge that raises the algebraic
+  // connectivity the most to first order. The Fiedler vector is kept between calls and refined by warm-started power
+  // iterations until its eigen-residual is small, so a suggestion costs O(n log n + iterations * judgements).
+  class QuestionSelector {
+  public:
+    using Pair = std::pair<Eigen::Index, Eigen::Index>;
+
+    explicit QuestionSelector(Eigen::Index n);
+
+    void addJudgement(Eigen::Index i, Eigen::Index j);   // no-op for the diagonal and pairs already judged
+    std::optional<Pair> next();                          // nullopt once every pair is judged
+
+    Eigen::Index size() const { return n_; }
+    size_t judged() const { return judged_.size(); }
+    Eigen::Index components() const { return components_; }
+    double algebraicConnectivity() const { return lambda2_; }   // estimate from the last next(), 0 while disconnected
+
+  private:
+    Eigen::Index find(Eigen::Index x);
+    bool isJudged(Eigen::Index i, Eigen::Index j) const;
+    Pair joinComponents();
+    Pair widestUnjudgedPair();
+    void refineFiedlerVector();
+
+    Eigen::Index n_;
+    std::vector<std::vector<Eigen::Index>> neighbours_;
+    std::unordered_set<Eigen::Index> judged_;   // i * n + j with i < j
+    std::vector<Eigen::Index> parent_;          // union-find over the judged pairs
+    std::vector<Eigen::Index> componentSize_;
+    Eigen::Index components_;
+    Eigen::Index maxDegree_ = 0;
+
+    Eigen::VectorXd fiedler_;                   // empty until the graph is first connected
+    Eigen::VectorXd product_;
+    std::vector<Eigen::Index> order_;           // nodes by ascending Fiedler value
+    double lambda2_ = 0.0;
+  };
+}
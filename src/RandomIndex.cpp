@@ -0,0 +1,229 @@
+#include "RandomIndex.h"
+#include "logging.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  constexpr std::array<double, 17> SaatyScale = {
+    1.0/9, 1.0/8, 1.0/7, 1.0/6, 1.0/5, 1.0/4, 1.0/3, 1.0/2, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0
+  };
+
+  constexpr char CacheMagic[8] = {'A', 'H', 'P', 'R', 'I', '0', '0', '1'};
+
+  // On-disk record, native byte order; the file is the magic followed by records
+  struct CacheEntry {
+    std::uint32_t n;
+    std::uint32_t method;
+    std::uint64_t samples;
+    std::uint64_t seed;
+    double randomIndex;
+  };
+
+  constexpr std::uint64_t DefaultSeed = 1;
+
+  struct Table {
+    // lock-free reads from the ranking kernels, NaN marks sizes not simulated yet
+    std::array<std::array<std::atomic<double>, AHP::MaxRandomIndexSize + 1>, AHP::PriorityMethodCount> values;
+
+    std::mutex mutex;   // guards everything below, taken only to publish a simulation
+    std::array<std::vector<std::uint64_t>, AHP::PriorityMethodCount> samples;
+    int fd = -1;
+
+    Table() {
+      for (size_t m = 0; m < values.size(); m++) {
+        for (auto& value : values[m]) {
+          value.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+        }
+        samples[m].assign(AHP::MaxRandomIndexSize + 1, 0);
+      }
+    }
+  };
+
+  Table& table() {
+    static Table instance;
+    return instance;
+  }
+
+  // Keeps the estimate with the most samples; the caller holds the table mutex
+  bool storeEntry(Table& t, const CacheEntry& entry) {
+    if (entry.n > AHP::MaxRandomIndexSize || entry.method >= AHP::PriorityMethodCount ||
+        entry.samples <= t.samples[entry.method][entry.n])
+      return false;
+    t.samples[entry.method][entry.n] = entry.samples;
+    t.values[entry.method][entry.n].store(entry.randomIndex, std::memory_order_relaxed);
+    return true;
+  }
+
+  // splitmix64 finalizer of a counter; lanes do not depend on each other, so filling a block vectorizes
+  inline std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // Scale positions of one sample's upper triangle, from a stream keyed by (seed, n, sample)
+  void fillScalePicks(std::vector<std::uint32_t>& picks, std::uint64_t seed, Eigen::Index n, size_t sample) {
+    const std::uint64_t base = mix(mix(seed ^ (static_cast<std::uint64_t>(n) << 32)) + sample);
+    const size_t count = picks.size();
+    std::uint32_t* out = picks.data();
+    for (size_t k = 0; k < count; k++) {
+      out[k] = static_cast<std::uint32_t>(((mix(base + k) >> 32) * SaatyScale.size()) >> 32);   // unbiased enough for 17 values
+    }
+  }
+}
+
+size_t AHP::defaultRandomIndexSamples(Eigen::Index n) {
+  const double budget = 2e7 / static_cast<double>(n * n);   // about 2e7 cells per simulation
+  return static_cast<size_t>(std::clamp(budget, 100.0, 10000.0));
+}
+
+double AHP::simulateRandomIndex(Eigen::Index n, size_t samples, AHP::PriorityMethod method, std::uint64_t seed) {
+  tracing::Span span("simulateRandomIndex");
+  if (n <= 2 || samples == 0)
+    return 0.0;
+
+  constexpr size_t ChunkSamples = 8;
+  const size_t chunks = (samples + ChunkSamples - 1) / ChunkSamples;
+  const size_t cells = static_cast<size_t>(n * (n - 1) / 2);
+  std::vector<double> lambdaSums(chunks, 0.0);
+
+  // chunks own their buffers and partial sums, so the reduction order is fixed
+  parallel::parallelFor(chunks, ChunkSamples * n * n, [&](Eigen::Index chunk) {
+    AHP::Matrix2D matrix = AHP::Matrix2D::Ones(n, n);
+    Eigen::VectorXd weights(n), products(n);
+    std::vector<std::uint32_t> picks(cells);
+
+    const size_t end = std::min(samples, (chunk + 1) * ChunkSamples);
+    for (size_t sample = chunk * ChunkSamples; sample < end; sample++) {
+      fillScalePicks(picks, seed, n, sample);
+      size_t k = 0;
+      for (Eigen::Index j = 1; j < n; j++) {
+        for (Eigen::Index i = 0; i < j; i++, k++) {
+          matrix(i, j) = SaatyScale[picks[k]];
+          matrix(j, i) = SaatyScale[SaatyScale.size() - 1 - picks[k]];
+        }
+      }
+      lambdaSums[chunk] += lambdaMax(matrix, method, weights, products);
+    }
+  });
+
+  double lambdaSum = 0.0;
+  for (double sum : lambdaSums) {
+    lambdaSum += sum;
+  }
+  const double meanLambda = lambdaSum / samples;
+  return (meanLambda - n) / (n - 1);
+}
+
+double AHP::simulatedRandomIndex(Eigen::Index n, AHP::PriorityMethod method) {
+  if (n < 0 || n > MaxRandomIndexSize)
+    return std::numeric_limits<double>::quiet_NaN();
+  return table().values[static_cast<size_t>(method)][n].load(std::memory_order_relaxed);
+}
+
+double AHP::ensureRandomIndex(Eigen::Index n, AHP::PriorityMethod method) {
+  if (n >= 1 && n <= static_cast<Eigen::Index>(RandomIndex.size()))
+    return RandomIndex[n-1];
+  if (n < 1 || n > MaxRandomIndexSize)
+    return std::numeric_limits<double>::quiet_NaN();
+
+  const double known = simulatedRandomIndex(n, method);
+  if (!std::isnan(known))
+    return known;
+
+  // simulated unlocked so that other sizes are not held up; a concurrent caller of the same size may simulate it
+  // too, the first to publish wins and the same arguments give both the same value
+  CacheEntry entry{static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(method), defaultRandomIndexSamples(n), DefaultSeed, 0.0};
+  entry.randomIndex = simulateRandomIndex(n, entry.samples, method, entry.seed);
+
+  auto& t = table();
+  std::lock_guard lock(t.mutex);
+  if (!storeEntry(t, entry))
+    return simulatedRandomIndex(n, method);
+  // the index is in memory either way, a cache that cannot take it only costs a later run the simulation
+  if (t.fd >= 0 && ::write(t.fd, &entry, sizeof(entry)) != static_cast<ssize_t>(sizeof(entry))) {
+    logger::error(fmt::format("Random index cache disabled: could not append the {}x{} index", n, n));
+    ::close(t.fd);
+    t.fd = -1;
+  }
+  return entry.randomIndex;
+}
+
+size_t AHP::loadRandomIndexCache(const std::string& path) {
+  tracing::Span span("loadRandomIndexCache");
+  auto& t = table();
+  std::lock_guard lock(t.mutex);
+
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open random index cache: " + path);
+  }
+
+  struct stat st{};
+  ::fstat(fd, &st);
+  const size_t size = static_cast<size_t>(st.st_size);
+  size_t loaded = 0;
+
+  if (size == 0) {
+    if (::write(fd, CacheMagic, sizeof(CacheMagic)) != static_cast<ssize_t>(sizeof(CacheMagic))) {
+      ::close(fd);
+      throw std::runtime_error("Could not initialize random index cache: " + path);
+    }
+  } else {
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Could not map random index cache: " + path);
+    }
+
+    const char* bytes = static_cast<const char*>(mapped);
+    const bool valid = size >= sizeof(CacheMagic) && std::memcmp(bytes, CacheMagic, sizeof(CacheMagic)) == 0;
+    // a torn record at the end (crash while appending) is not loaded, and cut off below so appends stay aligned
+    const size_t count = valid ? (size - sizeof(CacheMagic)) / sizeof(CacheEntry) : 0;
+    if (valid) {
+      for (size_t i = 0; i < count; i++) {
+        CacheEntry entry;
+        std::memcpy(&entry, bytes + sizeof(CacheMagic) + i * sizeof(CacheEntry), sizeof(entry));
+        storeEntry(t, entry);
+        loaded++;
+      }
+    }
+    ::munmap(mapped, size);
+
+    if (!valid) {
+      ::close(fd);
+      throw std::runtime_error("Not a random index cache: " + path);
+    }
+
+    const size_t intact = sizeof(CacheMagic) + count * sizeof(CacheEntry);
+    if (size > intact) {
+      if (::ftruncate(fd, static_cast<off_t>(intact)) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not drop the torn record at the end of random index cache: " + path);
+      }
+      logger::error(fmt::format("Random index cache {}: dropped a torn {}-byte record at the end", path, size - intact));
+    }
+  }
+
+  if (t.fd >= 0) {
+    ::close(t.fd);
+  }
+  t.fd = fd;
+  return loaded;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <cstdint>
+#include <string>
+
+// Random consistency indices beyond Saaty's table: the mean CI of random reciprocal matrices on the 1/9..9 scale,
+// simulated per size and priority method since every method estimates lambda max differently. Simulated indices live
+// in an in-memory table backed by an append-only cache file that is mapped and read back at startup.
+namespace AHP {
+  constexpr Eigen::Index MaxRandomIndexSize = 4096;
+
+  size_t defaultRandomIndexSamples(Eigen::Index n);   // fewer samples for large n, where CI varies less
+
+  // Mean CI of `samples` random matrices, in parallel; the result depends only on the arguments, not on the thread count
+  double simulateRandomIndex(Eigen::Index n, size_t samples, PriorityMethod method, std::uint64_t seed = 1);
+
+  double simulatedRandomIndex(Eigen::Index n, PriorityMethod method);   // NaN unless loaded or simulated
+
+  // RI of an n x n matrix, simulated with the default sample count and cached when not known yet;
+  // NaN above MaxRandomIndexSize. A failed append to the cache file is logged and stops later appends.
+  double ensureRandomIndex(Eigen::Index n, PriorityMethod method);
+
+  // Reads every entry of the cache file (created if missing) and appends later simulations to it, returns the entry count.
+  // Throws std::runtime_error if the file cannot be opened or is not a random index cache.
+  size_t loadRandomIndexCache(const std::string& path);
+}
@@ -0,0 +1,79 @@
+#include "Sensitivity.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+std::vector<AHP::CriterionSensitivity> AHP::criteriaSensitivity(Eigen::Ref<const Eigen::VectorXd> criteria_weights,
+                                                                AHP::MatrixRef local_weights) {
+  tracing::Span span("criteriaSensitivity");
+  if (local_weights.cols() != criteria_weights.size()) {
+    throw std::invalid_argument("Expected one column of local weights per criterion");
+  }
+  const Eigen::Index n = local_weights.rows();
+  const Eigen::VectorXd ranking = local_weights * criteria_weights;
+  Eigen::Index top = 0;
+  ranking.maxCoeff(&top);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  std::vector<AHP::CriterionSensitivity> result(criteria_weights.size());
+  parallel::parallelFor(criteria_weights.size(), n * n, [&](Eigen::Index k) {
+    auto& sensitivity = result[k];
+    const double weight = criteria_weights(k);
+    const double rest = 1.0 - weight;
+    sensitivity.weight = weight;
+    sensitivity.criticalDelta = nan;
+    sensitivity.overtake = Eigen::VectorXd::Constant(n, nan);
+    if (!(rest > 1e-12)) {
+      sensitivity.lower = sensitivity.upper = sensitivity.topLower = sensitivity.topUpper = weight;
+      return;
+    }
+
+    // d R_a / d delta; a and b tie at delta = (R_a - R_b) / (slope_b - slope_a)
+    const Eigen::VectorXd slope = local_weights.col(k) - (ranking - local_weights.col(k) * weight) / rest;
+    const double minDelta = -weight, maxDelta = rest;
+    const double inf = std::numeric_limits<double>::infinity();
+    double below = minDelta, above = maxDelta, topBelow = minDelta, topAbove = maxDelta;
+    double nearest = inf;
+    Eigen::ArrayXd deltas(n);
+
+    for (Eigen::Index a = 0; a < n - 1; a++) {
+      // the row's divisions are vectorized, the reductions below are not
+      const Eigen::Index others = n - a - 1;
+      deltas.tail(others) = (ranking(a) - ranking.tail(others).array()) / (slope.tail(others).array() - slope(a));
+      for (Eigen::Index b = a + 1; b < n; b++) {
+        const double delta = deltas(b);
+        const bool feasible = delta >= minDelta && delta <= maxDelta;   // false for parallel lines, inf or NaN
+        // selects rather than branches, the bounds only move for a few of the n^2 pairs
+        above = std::min(above, feasible && delta >= 0.0 ? delta : maxDelta);
+        below = std::max(below, feasible && delta <= 0.0 ? delta : minDelta);
+        const double distance = feasible ? std::abs(delta) : inf;
+        if (distance < nearest) {
+          nearest = distance;
+          sensitivity.criticalDelta = delta;
+          sensitivity.criticalFirst = ranking(a) >= ranking(b) ? a : b;
+          sensitivity.criticalSecond = ranking(a) >= ranking(b) ? b : a;
+        }
+      }
+    }
+
+    for (Eigen::Index b = 0; b < n; b++) {
+      const double delta = (ranking(top) - ranking(b)) / (slope(b) - slope(top));
+      if (b == top || !(delta >= minDelta && delta <= maxDelta))
+        continue;
+      sensitivity.overtake(b) = delta;
+      if (delta >= 0.0)
+        topAbove = std::min(topAbove, delta);
+      if (delta <= 0.0)
+        topBelow = std::max(topBelow, delta);
+    }
+
+    sensitivity.lower = weight + below;
+    sensitivity.upper = weight + above;
+    sensitivity.topLower = weight + topBelow;
+    sensitivity.topUpper = weight + topAbove;
+  });
+  return result;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <vector>
+
+// Sensitivity of the additive model ranking = localWeights * criteriaWeights to one criterion weight. Changing c_k by
+// delta while the other weights keep their proportions moves every alternative linearly,
+// R_a(delta) = R_a + delta * (L_ak - (R_a - L_ak c_k) / (1 - c_k)), so each pair's rank reversal threshold is a single
+// division and all thresholds of all criteria take one O(criteria * n^2) pass.
+namespace AHP {
+  struct CriterionSensitivity {
+    double weight;                   // current weight c_k
+    double lower, upper;             // weight interval in which no pair of alternatives swaps
+    double topLower, topUpper;       // weight interval in which the top alternative stays first
+    Eigen::Index criticalFirst = -1; // pair swapping closest to the current weight, better-ranked first; -1 if none in [0, 1]
+    Eigen::Index criticalSecond = -1;
+    double criticalDelta;            // signed weight change at which the critical pair swaps, NaN if none
+    Eigen::VectorXd overtake;        // per alternative, signed weight change at which it overtakes the top, NaN if never
+  };
+
+  // One entry per criterion. Intervals are clamped to [0, 1]; with a single criterion (c_k = 1) nothing can move and
+  // the interval is the point 1.
+  std::vector<CriterionSensitivity> criteriaSensitivity(Eigen::Ref<const Eigen::VectorXd> criteria_weights,
+                                                        MatrixRef local_weights);
+}
@@ -0,0 +1,260 @@
+#include "Uncertainty.h"
+#include "parallel.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  constexpr Eigen::Index Batch = 256;
+  constexpr double MaxSaatyPosition = 8.0;   // 1/9 .. 1 .. 9 as -8 .. 0 .. 8
+
+  // splitmix64 stream, five times cheaper per draw than mt19937_64 and statistically plenty for noise
+  struct NoiseStream {
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    std::uint64_t state;
+
+    NoiseStream(std::uint64_t seed, std::uint64_t stream) : state(seed) {
+      state = (*this)() ^ (stream * 0xd1b54a32d192ed03ULL);   // streams of one seed start far apart
+    }
+
+    result_type operator()() {
+      std::uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+  };
+
+  double saatyPosition(double value) { return value >= 1.0 ? value - 1.0 : 1.0 - 1.0 / value; }
+  double fromSaatyPosition(double position) { return position >= 0.0 ? position + 1.0 : 1.0 / (1.0 - position); }
+
+  // Upper triangle of one matrix, with the log change of one Saaty step down and up for every judgement
+  struct Judgements {
+    Eigen::Index n;
+    Eigen::RowVectorXd logRowMeans;   // log geometric-mean weights of the unperturbed matrix, before normalization
+    std::vector<Eigen::Index> rows, cols;
+    Eigen::ArrayXd stepDown, stepUp;
+
+    explicit Judgements(AHP::MatrixRef matrix) : n(matrix.rows()) {
+      logRowMeans = matrix.array().log().rowwise().mean().matrix().transpose();
+      const Eigen::Index count = n * (n - 1) / 2;
+      stepDown.resize(count);
+      stepUp.resize(count);
+      for (Eigen::Index j = 1, k = 0; j < n; j++) {
+        for (Eigen::Index i = 0; i < j; i++, k++) {
+          const double position = saatyPosition(matrix(i, j));
+          const double logValue = std::log(matrix(i, j));
+          rows.push_back(i);
+          cols.push_back(j);
+          stepDown(k) = std::log(fromSaatyPosition(std::max(position - 1.0, -MaxSaatyPosition))) - logValue;
+          stepUp(k) = std::log(fromSaatyPosition(std::min(position + 1.0, MaxSaatyPosition))) - logValue;
+        }
+      }
+    }
+
+    Eigen::Index size() const { return static_cast<Eigen::Index>(rows.size()); }
+  };
+
+  // Normal draws with standard deviation sigma by Box-Muller in single precision, where Eigen vectorizes log, sin and
+  // cos; 24-bit uniforms cut the tails beyond about 5.9 sigma, which noise does not miss
+  void fillNormals(double* out, Eigen::Index count, double sigma, NoiseStream& rng) {
+    constexpr Eigen::Index Pairs = 256;
+    constexpr float TwoPi = 6.2831853f;
+    Eigen::ArrayXf radius(Pairs), angle(Pairs);
+    for (Eigen::Index first = 0; first < count; first += 2 * Pairs) {
+      const Eigen::Index chunk = std::min(2 * Pairs, count - first);
+      const Eigen::Index pairs = (chunk + 1) / 2;
+      for (Eigen::Index k = 0; k < pairs; k++) {
+        const std::uint64_t bits = rng();
+        radius(k) = (static_cast<float>(bits >> 40) + 0.5f) * 0x1p-24f;   // in (0, 1)
+        angle(k) = static_cast<float>((bits >> 8) & 0xFFFFFF) * (TwoPi * 0x1p-24f);
+      }
+      radius.head(pairs) = (-2.0f * radius.head(pairs).log()).sqrt();
+
+      Eigen::Map<Eigen::ArrayXd> cosines(out + first, pairs), sines(out + first + pairs, chunk - pairs);
+      cosines = sigma * (radius.head(pairs) * angle.head(pairs).cos()).cast<double>();
+      sines = sigma * (radius.head(chunk - pairs) * angle.head(chunk - pairs).sin()).cast<double>();
+    }
+  }
+
+  // Log noise of every judgement of a batch, simulations x judgements
+  void drawJudgementNoise(const Judgements& judgements, AHP::JudgementNoise noise, double sigma, Eigen::Index count,
+                          NoiseStream& rng, AHP::Matrix2D& out) {
+    out.resize(count, judgements.size());
+    if (noise == AHP::JudgementNoise::LogNormal) {
+      fillNormals(out.data(), out.size(), sigma, rng);
+      return;
+    }
+    // one random bit per judgement, picking the step from a table rather than a branch the predictor cannot learn
+    for (Eigen::Index k = 0; k < judgements.size(); k++) {
+      const double steps[2] = {judgements.stepDown(k), judgements.stepUp(k)};
+      for (Eigen::Index s = 0; s < count; s += 64) {
+        const std::uint64_t bits = rng();
+        const Eigen::Index end = std::min<Eigen::Index>(count, s + 64);
+        for (Eigen::Index b = s; b < end; b++) {
+          out(b, k) = steps[(bits >> (b - s)) & 1];
+        }
+      }
+    }
+  }
+
+  // Geometric-mean weights of a batch of perturbed matrices, simulations x n. Only the row sums of the log noise move
+  // the weights; for i.i.d. normal noise they are distributed as z - mean(z) with z ~ N(0, n sigma^2 I), so n draws per
+  // simulation replace n(n-1)/2.
+  void geometricMeanBatch(const Judgements& judgements, AHP::JudgementNoise noise, double sigma, Eigen::Index count,
+                          NoiseStream& rng, AHP::Matrix2D& cellNoise, AHP::Matrix2D& weights) {
+    const Eigen::Index n = judgements.n;
+    weights.resize(count, n);
+    if (noise == AHP::JudgementNoise::LogNormal) {
+      fillNormals(weights.data(), weights.size(), sigma * std::sqrt(static_cast<double>(n)), rng);
+      weights.colwise() -= weights.rowwise().mean();
+    } else {
+      drawJudgementNoise(judgements, noise, sigma, count, rng, cellNoise);
+      weights.setZero();
+      for (Eigen::Index k = 0; k < judgements.size(); k++) {
+        weights.col(judgements.rows[k]) += cellNoise.col(k);
+        weights.col(judgements.cols[k]) -= cellNoise.col(k);
+      }
+    }
+
+    weights = ((weights / static_cast<double>(n)).rowwise() + judgements.logRowMeans).array().exp().matrix();
+    weights.array().colwise() /= weights.rowwise().sum().array();
+  }
+
+  void perturb(AHP::MatrixRef matrix, const Judgements& judgements, const AHP::Matrix2D& cellNoise, Eigen::Index simulation,
+               AHP::Matrix2D& out) {
+    out = matrix;
+    for (Eigen::Index k = 0; k < judgements.size(); k++) {
+      const Eigen::Index i = judgements.rows[k], j = judgements.cols[k];
+      out(i, j) *= std::exp(cellNoise(simulation, k));
+      out(j, i) = 1.0 / out(i, j);
+    }
+  }
+
+  // Alternatives from best to worst; ties keep index order. std::sort with the index as tie-break, unlike stable_sort,
+  // does not allocate once per simulation
+  template <typename Ranking>
+  void rankOrder(const Ranking& ranking, std::vector<Eigen::Index>& order) {
+    order.resize(ranking.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](Eigen::Index a, Eigen::Index b) {
+      return ranking(a) > ranking(b) || (ranking(a) == ranking(b) && a < b);
+    });
+  }
+}
+
+AHP::UncertaintyResult AHP::simulateJudgementUncertainty(AHP::MatrixRef criteria_comparison,
+                                                         std::span<const AHP::Matrix2D> alternatives_comparisons,
+                                                         AHP::PriorityMethod method, AHP::JudgementNoise noise, double sigma,
+                                                         size_t simulations, std::uint64_t seed) {
+  tracing::Span span("simulateJudgementUncertainty");
+  const Eigen::Index critCount = criteria_comparison.rows();
+  if (simulations == 0) {
+    throw std::invalid_argument("Uncertainty simulation needs at least one simulation");
+  }
+  if (noise == JudgementNoise::LogNormal && !(std::isfinite(sigma) && sigma >= 0.0)) {
+    throw std::invalid_argument("Noise sigma must be finite and non-negative");
+  }
+  if (alternatives_comparisons.empty() || static_cast<Eigen::Index>(alternatives_comparisons.size()) != critCount) {
+    throw std::invalid_argument("Expected one alternatives matrix per criterion");
+  }
+  const Eigen::Index altCount = alternatives_comparisons[0].rows();
+
+  AHP::RankingWorkspace unperturbed;
+  AHP::AHPRanker(method).calculateRanking(criteria_comparison, alternatives_comparisons, unperturbed);
+  std::vector<Eigen::Index> baseOrder, basePlace(altCount);
+  rankOrder(unperturbed.ranking, baseOrder);
+  for (Eigen::Index place = 0; place < altCount; place++) {
+    basePlace[baseOrder[place]] = place;
+  }
+
+  const Judgements critJudgements(criteria_comparison);
+  std::vector<Judgements> altJudgements;
+  for (auto& matrix : alternatives_comparisons) {
+    altJudgements.emplace_back(matrix);
+  }
+  // for complete matrices logarithmic least squares gives the geometric-mean weights
+  const bool closedForm = method == PriorityMethod::GeometricMean || method == PriorityMethod::LogLeastSquares;
+
+  const Eigen::Index batches = (simulations + Batch - 1) / Batch;
+  AHP::Matrix2D sums(altCount, batches), sumSquares(altCount, batches);
+  std::vector<AHP::RankingWorkspace> workspaces(closedForm ? 0 : parallel::threadCount());
+  Eigen::Matrix<std::int64_t, Eigen::Dynamic, Eigen::Dynamic> placeCounts =
+    Eigen::Matrix<std::int64_t, Eigen::Dynamic, Eigen::Dynamic>::Zero(altCount, altCount);
+  std::mutex countsMutex;   // integer counts, so merging in any order gives the same result
+
+  const Eigen::Index cells = critCount * critCount + critCount * altCount * altCount;
+  parallel::parallelFor(batches, Batch * cells, [&](Eigen::Index batch) {
+    const Eigen::Index count = std::min<Eigen::Index>(Batch, simulations - batch * Batch);
+    NoiseStream rng(seed, batch);
+
+    AHP::Matrix2D rankings(count, altCount);   // simulations x alternatives
+    if (closedForm) {
+      AHP::Matrix2D cellNoise, critWeights, altWeights;
+      geometricMeanBatch(critJudgements, noise, sigma, count, rng, cellNoise, critWeights);
+      rankings.setZero();
+      for (Eigen::Index c = 0; c < critCount; c++) {
+        geometricMeanBatch(altJudgements[c], noise, sigma, count, rng, cellNoise, altWeights);
+        rankings.array() += altWeights.array().colwise() * critWeights.col(c).array();
+      }
+    } else {
+      AHP::Matrix2D critNoise;
+      std::vector<AHP::Matrix2D> altNoise(critCount);
+      drawJudgementNoise(critJudgements, noise, sigma, count, rng, critNoise);
+      for (Eigen::Index c = 0; c < critCount; c++) {
+        drawJudgementNoise(altJudgements[c], noise, sigma, count, rng, altNoise[c]);
+      }
+
+      AHP::AHPRanker ranker(method);
+      AHP::RankingWorkspace& ws = workspaces[parallel::workerIndex()];
+      AHP::Matrix2D critMatrix;
+      std::vector<AHP::Matrix2D> altMatrices(critCount);
+      for (Eigen::Index s = 0; s < count; s++) {
+        perturb(criteria_comparison, critJudgements, critNoise, s, critMatrix);
+        for (Eigen::Index c = 0; c < critCount; c++) {
+          perturb(alternatives_comparisons[c], altJudgements[c], altNoise[c], s, altMatrices[c]);
+        }
+        ws.warmStartFrom(unperturbed);   // whichever worker ranks it, a simulation starts from the same weights
+        ranker.calculateRanking(critMatrix, altMatrices, ws);
+        rankings.row(s) = ws.ranking.transpose();
+      }
+    }
+
+    sums.col(batch) = rankings.colwise().sum().transpose();
+    sumSquares.col(batch) = rankings.array().square().colwise().sum().transpose();
+
+    Eigen::Matrix<std::int64_t, Eigen::Dynamic, Eigen::Dynamic> counts =
+      Eigen::Matrix<std::int64_t, Eigen::Dynamic, Eigen::Dynamic>::Zero(altCount, altCount);
+    std::vector<Eigen::Index> order;
+    for (Eigen::Index s = 0; s < count; s++) {
+      rankOrder(rankings.row(s), order);
+      for (Eigen::Index place = 0; place < altCount; place++) {
+        counts(order[place], place)++;
+      }
+    }
+    std::lock_guard lock(countsMutex);
+    placeCounts += counts;
+  });
+
+  const double total = static_cast<double>(simulations);
+  AHP::UncertaintyResult result;
+  result.simulations = simulations;
+  result.meanWeight = sums.rowwise().sum() / total;
+  result.stdDevWeight = (sumSquares.rowwise().sum() / total - result.meanWeight.array().square().matrix())
+                          .cwiseMax(0.0).cwiseSqrt();
+  result.rankProbabilities = placeCounts.cast<double>() / total;
+  result.stability.resize(altCount);
+  for (Eigen::Index alt = 0; alt < altCount; alt++) {
+    result.stability(alt) = result.rankProbabilities(alt, basePlace[alt]);
+  }
+  return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "AHP.h"
+
+#include <cstdint>
+#include <span>
+
+// Monte Carlo sensitivity of a ranking to the judgements themselves: every judgement of the (aggregated) matrices is
+// perturbed, the survey reranked, and the spread of the outcomes reported per alternative.
+namespace AHP {
+  enum class JudgementNoise {
+    SaatyStep,   // each judgement moves one step down or up the 1/9..9 scale with equal odds, not beyond its ends
+    LogNormal    // each judgement is multiplied by exp(sigma * N(0, 1)), its reciprocal divided by the same factor
+  };
+
+  struct UncertaintyResult {
+    size_t simulations = 0;
+    Eigen::VectorXd meanWeight;     // per alternative, over the simulations
+    Eigen::VectorXd stdDevWeight;
+    Eigen::VectorXd stability;      // share of simulations keeping the alternative at its unperturbed place
+    Matrix2D rankProbabilities;     // (alternative, place): share of simulations ranking the alternative there, best first
+  };
+
+  // Perturbs the upper triangles of complete reciprocal matrices `simulations` times and reranks them by `method`.
+  // Simulations run in parallel batches, each with its own RNG stream derived from `seed`, so the result does not
+  // depend on the thread count. For the geometric mean and logarithmic least squares a batch is ranked in closed form
+  // from the row sums of the log noise, as array operations across the batch; other methods rebuild and rank every
+  // perturbed survey in a workspace reused by its worker, warm-started from the unperturbed weights.
+  UncertaintyResult simulateJudgementUncertainty(MatrixRef criteria_comparison, std::span<const Matrix2D> alternatives_comparisons,
+                                                 PriorityMethod method, JudgementNoise noise, double sigma, size_t simulations,
+                                                 std::uint64_t seed = 1);
+}
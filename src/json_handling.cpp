@@ -1,14 +1,51 @@
 #include "json_handling.h"
 #include "logging.h"
+#include "tracing.h"
 
 #include <json.h>
+#include <fmt/format.h>
+
+#include <cmath>
+#include <stdexcept>
 
 namespace json_handling
 {
+  AHP::PriorityMethod parsePriorityMethod(const std::string& name)
+  {
+    if(name == "geometricMean")   return AHP::PriorityMethod::GeometricMean;
+    if(name == "eigenvector")     return AHP::PriorityMethod::Eigenvector;
+    if(name == "columnAverage")   return AHP::PriorityMethod::ColumnAverage;
+    if(name == "logLeastSquares") return AHP::PriorityMethod::LogLeastSquares;
+
+    throw std::invalid_argument("Unknown priority method: " + name);
+  }
+
+  AHP::AggregationMode parseAggregationMode(const std::string& name)
+  {
+    if(name == "judgements")           return AHP::AggregationMode::Judgements;
+    if(name == "geometricPriorities")  return AHP::AggregationMode::GeometricPriorities;
+    if(name == "arithmeticPriorities") return AHP::AggregationMode::ArithmeticPriorities;
+
+    throw std::invalid_argument("Unknown aggregation mode: " + name);
+  }
+
+  AHP::JudgementNoise parseJudgementNoise(const std::string& name)
+  {
+    if(name == "saatyStep") return AHP::JudgementNoise::SaatyStep;
+    if(name == "logNormal") return AHP::JudgementNoise::LogNormal;
+
+    throw std::invalid_argument("Unknown judgement noise: " + name);
+  }
+
   SetupData parseSetup(const std::string& jsonStr)
   {
+    tracing::Span span("parseSetup");
     std::vector<std::string> alternatives;
     std::vector<std::string> criteria;
+    AHP::PriorityMethod priorityMethod = AHP::PriorityMethod::GeometricMean;
+    AHP::AggregationMode aggregation = AHP::AggregationMode::Judgements;
+    std::map<std::string, std::vector<std::string>> subcriteria;
+    double fuzzySpread = 0.0;
 
     json::jobject json = json::jobject::parse(jsonStr.c_str());
 
@@ -23,7 +60,27 @@ namespace json_handling
       criteria.push_back(i);
     }
 
-    return { alternatives, criteria };
+    if(json.has_key("priorityMethod")) {
+      priorityMethod = parsePriorityMethod(json["priorityMethod"].as_string());
+    }
+
+    if(json.has_key("aggregation")) {
+      aggregation = parseAggregationMode(json["aggregation"].as_string());
+    }
+
+    if(json.has_key("subcriteria")) {
+      json::jobject subcritObj = json["subcriteria"];
+      for(std::string criterion : subcritObj.list_keys()) {
+        std::vector<std::string> subcritArr = subcritObj[criterion].as_array();
+        subcriteria[criterion] = subcritArr;
+      }
+    }
+
+    if(json.has_key("fuzzySpread")) {
+      fuzzySpread = std::stod(json["fuzzySpread"].as_string());
+    }
+
+    return { alternatives, criteria, priorityMethod, aggregation, subcriteria, fuzzySpread };
   };
 
   AHP::ComparisonValues parseSingleAltComparisons(json::jobject& singleAltComparisons)
@@ -41,12 +98,12 @@ namespace json_handling
 
   AgentInput parseAgentInput(const std::string& jsonStr)
   {
+    tracing::Span span("parseAgentInput");
     AgentInput agentInput;
 
     json::jobject json = json::jobject::parse(jsonStr.c_str());
 
     json::jobject altComparisons = json["alternativeMatrices"];
-    json::jobject critComparisons = json["criteriaMatrix"];
 
     for(std::string criteria : altComparisons.list_keys()) {
       auto altCompByCriteria = altComparisons[criteria].as_object();
@@ -57,12 +114,162 @@ namespace json_handling
       }
     }
 
-    for(std::string criteria : critComparisons.list_keys()) {
-      auto critValues = critComparisons[criteria].as_object();
-      agentInput.critComparisons[criteria] = parseSingleAltComparisons(critValues);
+    // an agent judging only sub-criteria of a hierarchy may leave out the top-level matrix
+    if(json.has_key("criteriaMatrix") || !json.has_key("subcriteriaMatrices")) {
+      json::jobject critComparisons = json["criteriaMatrix"];
+      for(std::string criteria : critComparisons.list_keys()) {
+        auto critValues = critComparisons[criteria].as_object();
+        agentInput.critComparisons[criteria] = parseSingleAltComparisons(critValues);
+      }
+    }
+
+    if(json.has_key("subcriteriaMatrices")) {
+      json::jobject subcritComparisons = json["subcriteriaMatrices"];
+      for(std::string criteria : subcritComparisons.list_keys()) {
+        auto subcritByCriteria = subcritComparisons[criteria].as_object();
+
+        for(std::string subcrit : subcritByCriteria.list_keys()) {
+          auto subcritValues = subcritByCriteria[subcrit].as_object();
+          agentInput.subcritComparisons[criteria][subcrit] = parseSingleAltComparisons(subcritValues);
+        }
+      }
+    }
+
+    if(json.has_key("weight")) {
+      agentInput.weight = std::stod(json["weight"].as_string());
     }
 
     return agentInput;
   };
 
+  WeightUpdate parseWeightUpdate(const std::string& jsonStr)
+  {
+    json::jobject json = json::jobject::parse(jsonStr.c_str());
+    // stoul would wrap "-1" around to the largest size_t
+    const long long agent = std::stoll(json["agent"].as_string());
+    if(agent < 0) {
+      throw std::invalid_argument("Agent index must be non-negative");
+    }
+    return { static_cast<size_t>(agent), std::stod(json["weight"].as_string()) };
+  }
+
+  WhatIfRequest parseWhatIf(const std::string& jsonStr)
+  {
+    WhatIfRequest request;
+
+    json::jobject json = json::jobject::parse(jsonStr.c_str());
+    if(json.has_key("criteriaWeights")) {
+      json::jobject weights = json["criteriaWeights"];
+      request.criteriaWeights = parseSingleAltComparisons(weights);
+    }
+
+    if(json.has_key("criteriaMatrix")) {
+      json::jobject critComparisons = json["criteriaMatrix"];
+      for(std::string criteria : critComparisons.list_keys()) {
+        auto critValues = critComparisons[criteria].as_object();
+        request.criteriaMatrix[criteria] = parseSingleAltComparisons(critValues);
+      }
+    }
+
+    if(!request.criteriaWeights.empty() && !request.criteriaMatrix.empty()) {
+      throw std::invalid_argument("Expected criteriaWeights or criteriaMatrix, not both");
+    }
+    return request;
+  }
+
+  NetworkInput parseNetwork(const std::string& jsonStr)
+  {
+    tracing::Span span("parseNetwork");
+    NetworkInput network;
+
+    json::jobject json = json::jobject::parse(jsonStr.c_str());
+
+    json::jobject clusters = json["clusters"];
+    for(std::string cluster : clusters.list_keys()) {
+      std::vector<std::string> nodes = clusters[cluster].as_array();
+      network.clusters.push_back({cluster, nodes});
+    }
+
+    json::jobject nodeComparisons = json["nodeMatrices"];
+    for(std::string node : nodeComparisons.list_keys()) {
+      auto byCluster = nodeComparisons[node].as_object();
+
+      for(std::string cluster : byCluster.list_keys()) {
+        auto comparisons = byCluster[cluster].as_object();
+
+        for(std::string item : comparisons.list_keys()) {
+          auto values = comparisons[item].as_object();
+          network.nodeComparisons[node][cluster][item] = parseSingleAltComparisons(values);
+        }
+      }
+    }
+
+    if(json.has_key("clusterMatrices")) {
+      json::jobject clusterComparisons = json["clusterMatrices"];
+      for(std::string cluster : clusterComparisons.list_keys()) {
+        auto comparisons = clusterComparisons[cluster].as_object();
+
+        for(std::string item : comparisons.list_keys()) {
+          auto values = comparisons[item].as_object();
+          network.clusterComparisons[cluster][item] = parseSingleAltComparisons(values);
+        }
+      }
+    }
+
+    return network;
+  }
+
+  QuestionRequest parseQuestionRequest(const std::string& jsonStr)
+  {
+    QuestionRequest request;
+
+    json::jobject json = json::jobject::parse(jsonStr.c_str());
+    request.session = json["session"].as_string();
+
+    if(json.has_key("criterion")) {
+      request.criterion = json["criterion"].as_string();
+    }
+
+    if(json.has_key("answered")) {
+      json::jobject answered = json["answered"];
+      for(std::string item : answered.list_keys()) {
+        auto values = answered[item].as_object();
+        request.answered[item] = parseSingleAltComparisons(values);
+      }
+    }
+
+    return request;
+  }
+
+  std::string quote(std::string_view text)
+  {
+    std::string quoted;
+    quoted.reserve(text.size() + 2);
+    quoted += '"';
+    for(char c : text) {
+      switch(c) {
+        case '"':  quoted += "\\\""; break;
+        case '\\': quoted += "\\\\"; break;
+        case '\b': quoted += "\\b"; break;
+        case '\f': quoted += "\\f"; break;
+        case '\n': quoted += "\\n"; break;
+        case '\r': quoted += "\\r"; break;
+        case '\t': quoted += "\\t"; break;
+        default:
+          if(static_cast<unsigned char>(c) < 0x20) {
+            quoted += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+          } else {
+            quoted += c;
+          }
+      }
+    }
+    quoted += '"';
+    return quoted;
+  }
+
+  std::string number(double value)
+  {
+    return std::isfinite(value) ? fmt::format("{}", value) : std::string("null");
+  }
+
 } // namespace json_handling
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "AHP.h"
+#include "Uncertainty.h"
 
+#include <map>
 #include <vector>
 #include <string>
-#include <tuple>
+#include <string_view>
+#include <utility>
 
 namespace json_handling
 {
@@ -12,9 +15,56 @@ namespace json_handling
   using AHP::Comparisons;
   using AHP::AgentInput;
   
-  using SetupData = std::tuple<std::vector<std::string>, std::vector<std::string>>;
+  struct SetupData {
+    std::vector<std::string> alternatives;
+    std::vector<std::string> criteria;
+    AHP::PriorityMethod priorityMethod = AHP::PriorityMethod::GeometricMean;   // optional "priorityMethod" key
+    AHP::AggregationMode aggregation = AHP::AggregationMode::Judgements;      // optional "aggregation" key
+    std::map<std::string, std::vector<std::string>> subcriteria;               // optional "subcriteria" key, criterion -> sub-criteria
+    double fuzzySpread = 0.0;                                                  // optional "fuzzySpread" key, 0 for crisp surveys only
+  };
+
+  // One /nextQuestion call of an agent's questionnaire session
+  struct QuestionRequest {
+    std::string session;
+    std::string criterion;    // alternatives compared under this criterion, empty for the criteria matrix
+    Comparisons answered;     // judgements given since the previous call of the session, optional "answered" key
+  };
+
+  // Admin change of one submission's expert weight
+  struct WeightUpdate {
+    size_t agent;     // index returned by /submit
+    double weight;
+  };
+
+  // /whatif input: either criteria weights overriding the survey's (criteria left out keep theirs, the result is
+  // renormalized) or a criteria matrix replacing the aggregated one
+  struct WhatIfRequest {
+    ComparisonValues criteriaWeights;   // optional "criteriaWeights" key, criterion -> weight
+    Comparisons criteriaMatrix;         // optional "criteriaMatrix" key, same layout as in a submission
+  };
+
+  // /anp input: the network's clusters in order, node -> cluster -> comparisons of that cluster's nodes with respect to
+  // the node ("nodeMatrices") and cluster -> comparisons of clusters with respect to it (optional "clusterMatrices")
+  struct NetworkInput {
+    std::vector<std::pair<std::string, std::vector<std::string>>> clusters;
+    std::map<std::string, std::map<std::string, Comparisons>> nodeComparisons;
+    std::map<std::string, Comparisons> clusterComparisons;
+  };
+
+  AHP::PriorityMethod parsePriorityMethod(const std::string& name);   // throws std::invalid_argument for unknown names
+  AHP::AggregationMode parseAggregationMode(const std::string& name); // throws std::invalid_argument for unknown names
+  AHP::JudgementNoise parseJudgementNoise(const std::string& name);   // throws std::invalid_argument for unknown names
 
   SetupData parseSetup(const std::string& jsonStr);
   AgentInput parseAgentInput(const std::string& jsonStr);
+  QuestionRequest parseQuestionRequest(const std::string& jsonStr);
+  WeightUpdate parseWeightUpdate(const std::string& jsonStr);
+  WhatIfRequest parseWhatIf(const std::string& jsonStr);
+  NetworkInput parseNetwork(const std::string& jsonStr);
+
+  // Responses are formatted with fmt; every client-supplied name and every double goes through these
+  std::string quote(std::string_view text);   // JSON string literal, quotes, backslashes and control characters escaped
+  std::string number(double value);           // shortest round-trip form, null for NaN and infinities
 
 } // namespace json_handling
\ No newline at end of file
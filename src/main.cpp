@@ -1,14 +1,52 @@
 #include "webserver.h"
+#include "RandomIndex.h"
+#include "tracing.h"
+#include "logging.h"
 
+#include <cstdlib>
+#include <filesystem>
 #include <restinio/all.hpp>
 
 
+// build/random_index.cache of the build tree the webserver runs from (it lands in build/bin), whatever the working directory
+std::string defaultRandomIndexCache()
+{
+  std::error_code error;
+  const std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+  if (error) {
+    return "build/random_index.cache";
+  }
+  return (executable.parent_path().parent_path() / "random_index.cache").string();
+}
+
 int main()
 {
+  // Tracing is off unless a dump file is configured (or it gets enabled via /trace)
+  const char* traceFile = std::getenv("AHP_TRACE_FILE");
+  if (traceFile) {
+    tracing::setEnabled(true);
+  }
+
+  // Random indices simulated by earlier runs, so large matrices get a CR without recomputation
+  const char* riCacheEnv = std::getenv("AHP_RI_CACHE");
+  const std::string riCache = riCacheEnv ? riCacheEnv : defaultRandomIndexCache();
+  try {
+    const size_t entries = AHP::loadRandomIndexCache(riCache);
+    logger::debug(fmt::format("Loaded {} random index entries from {}", entries, riCache));
+  }
+  catch(const std::exception& e) {
+    logger::error(fmt::format("Random index cache disabled: {}", e.what()));
+  }
+
   restinio::run(
     restinio::on_this_thread<webserver::serverTraits_t>()
       .port( 8080 )
       .address("0.0.0.0")
       .request_handler(webserver::createRequestHandler()) 
   );
+
+  if (traceFile) {
+    tracing::writeChromeTrace(traceFile);
+    logger::debug(fmt::format("Trace written to {}", traceFile));
+  }
 }
\ No newline at end of file
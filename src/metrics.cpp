@@ -0,0 +1,234 @@
+#include "metrics.h"
+
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fmt/format.h>
+
+namespace metrics
+{
+  namespace {
+    struct RouteSlot {
+      std::atomic<std::uint64_t> accepted{0};
+      std::atomic<std::uint64_t> rejected{0};
+      LatencyHistogram latency;
+    };
+
+    // Every thread owns one shard and is its only writer
+    struct Shard {
+      std::array<RouteSlot, kMaxRoutes> routes;
+      std::array<LatencyHistogram, kMaxStages> stages;
+    };
+
+    struct Registry {
+      std::mutex mutex;
+      std::vector<std::string> routeNames;
+      std::vector<std::string> stageNames;
+      std::vector<std::unique_ptr<Shard>> shards;
+    };
+
+    Registry& registry() {
+      static Registry instance;
+      return instance;
+    }
+
+    Shard& localShard() {
+      thread_local Shard* shard = [] {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.shards.push_back(std::make_unique<Shard>());
+        return reg.shards.back().get();
+      }();
+      return *shard;
+    }
+
+    // single writer, so a plain load/store pair is enough and avoids a locked RMW
+    inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta = 1) {
+      counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::uint64_t toNs(Clock::duration d) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+      return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    struct HistogramSnapshot {
+      std::array<std::uint64_t, LatencyHistogram::kBucketCount> buckets{};
+      std::uint64_t count = 0;
+      std::uint64_t sumNs = 0;
+
+      void add(const LatencyHistogram& h) {
+        for (size_t i = 0; i < buckets.size(); i++) {
+          const auto v = h.buckets[i].load(std::memory_order_relaxed);
+          buckets[i] += v;
+          count += v;
+        }
+        sumNs += h.sumNs.load(std::memory_order_relaxed);
+      }
+
+      double quantileSeconds(double q) const {
+        if (count == 0)
+          return 0.0;
+        const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+          seen += buckets[i];
+          if (seen >= rank)
+            return LatencyHistogram::bucketUpperBound(i) * 1e-9;
+        }
+        return LatencyHistogram::bucketUpperBound(buckets.size() - 1) * 1e-9;
+      }
+    };
+
+    // Prometheus bucket boundaries in seconds; HDR buckets are folded into these on export
+    constexpr std::array<double, 16> kExportBounds = {
+      0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+      0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+    };
+    constexpr std::array<double, 3> kQuantiles = { 0.5, 0.99, 0.999 };
+
+    void renderHistogram(std::string& out, const std::string& name, const std::string& labels,
+                         const HistogramSnapshot& snap) {
+      size_t idx = 0;
+      std::uint64_t cumulative = 0;
+      for (double bound : kExportBounds) {
+        const auto boundNs = static_cast<std::uint64_t>(bound * 1e9);
+        while (idx < snap.buckets.size() && LatencyHistogram::bucketUpperBound(idx) <= boundNs) {
+          cumulative += snap.buckets[idx++];
+        }
+        out += fmt::format("{}_bucket{{{},le=\"{}\"}} {}\n", name, labels, bound, cumulative);
+      }
+      out += fmt::format("{}_bucket{{{},le=\"+Inf\"}} {}\n", name, labels, snap.count);
+      out += fmt::format("{}_sum{{{}}} {}\n", name, labels, snap.sumNs * 1e-9);
+      out += fmt::format("{}_count{{{}}} {}\n", name, labels, snap.count);
+    }
+  }   // namespace
+
+  namespace stages {
+    const MetricId parse = registerStage("parse");
+    const MetricId aggregate = registerStage("aggregate");
+    const MetricId rank = registerStage("rank");
+    const MetricId render = registerStage("render");
+  } // namespace stages
+
+  /*    HISTOGRAM    */
+
+  std::size_t LatencyHistogram::bucketIndex(std::uint64_t valueNs) {
+    if (valueNs < kSubBuckets)
+      return static_cast<std::size_t>(valueNs);
+
+    const unsigned exponent = std::bit_width(valueNs) - 1;
+    if (exponent > kMaxExponent)
+      return kBucketCount - 1;
+
+    const unsigned shift = exponent - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + ((valueNs >> shift) & (kSubBuckets - 1));
+  }
+
+  std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t idx) {
+    if (idx < kSubBuckets)
+      return idx;
+
+    const unsigned shift = static_cast<unsigned>(idx / kSubBuckets) - 1;
+    const std::uint64_t sub = idx % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+  }
+
+  void LatencyHistogram::record(std::uint64_t valueNs) {
+    bump(buckets[bucketIndex(valueNs)]);
+    bump(sumNs, valueNs);
+  }
+
+  /*    REGISTRATION & RECORDING    */
+
+  MetricId registerRoute(const std::string& name) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    if (reg.routeNames.size() >= kMaxRoutes) {
+      throw std::length_error("Too many metric routes registered: " + name);
+    }
+    reg.routeNames.push_back(name);
+    return reg.routeNames.size() - 1;
+  }
+
+  MetricId registerStage(const std::string& name) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    if (reg.stageNames.size() >= kMaxStages) {
+      throw std::length_error("Too many metric stages registered: " + name);
+    }
+    reg.stageNames.push_back(name);
+    return reg.stageNames.size() - 1;
+  }
+
+  void recordRequest(MetricId route, Clock::duration latency, bool accepted) {
+    auto& slot = localShard().routes[route];
+    bump(accepted ? slot.accepted : slot.rejected);
+    slot.latency.record(toNs(latency));
+  }
+
+  void recordStage(MetricId stage, Clock::duration duration) {
+    localShard().stages[stage].record(toNs(duration));
+  }
+
+  /*    EXPOSITION    */
+
+  std::string renderPrometheus() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+
+    const size_t routeCount = reg.routeNames.size();
+    const size_t stageCount = reg.stageNames.size();
+
+    std::vector<std::uint64_t> accepted(routeCount, 0);
+    std::vector<std::uint64_t> rejected(routeCount, 0);
+    std::vector<HistogramSnapshot> routeLatency(routeCount);
+    std::vector<HistogramSnapshot> stageLatency(stageCount);
+
+    for (auto& shard : reg.shards) {
+      for (size_t r = 0; r < routeCount; r++) {
+        accepted[r] += shard->routes[r].accepted.load(std::memory_order_relaxed);
+        rejected[r] += shard->routes[r].rejected.load(std::memory_order_relaxed);
+        routeLatency[r].add(shard->routes[r].latency);
+      }
+      for (size_t s = 0; s < stageCount; s++) {
+        stageLatency[s].add(shard->stages[s]);
+      }
+    }
+
+    std::string out;
+
+    out += "# HELP ahp_http_requests_total Requests handled, by route and outcome.\n";
+    out += "# TYPE ahp_http_requests_total counter\n";
+    for (size_t r = 0; r < routeCount; r++) {
+      out += fmt::format("ahp_http_requests_total{{route=\"{}\",status=\"accepted\"}} {}\n", reg.routeNames[r], accepted[r]);
+      out += fmt::format("ahp_http_requests_total{{route=\"{}\",status=\"rejected\"}} {}\n", reg.routeNames[r], rejected[r]);
+    }
+
+    out += "# HELP ahp_http_request_duration_seconds Request handling latency, by route.\n";
+    out += "# TYPE ahp_http_request_duration_seconds histogram\n";
+    for (size_t r = 0; r < routeCount; r++) {
+      renderHistogram(out, "ahp_http_request_duration_seconds", fmt::format("route=\"{}\"", reg.routeNames[r]), routeLatency[r]);
+    }
+
+    out += "# HELP ahp_http_request_latency_quantile_seconds Request latency quantiles from the HDR histogram.\n";
+    out += "# TYPE ahp_http_request_latency_quantile_seconds gauge\n";
+    for (size_t r = 0; r < routeCount; r++) {
+      for (double q : kQuantiles) {
+        out += fmt::format("ahp_http_request_latency_quantile_seconds{{route=\"{}\",quantile=\"{}\"}} {}\n",
+          reg.routeNames[r], q, routeLatency[r].quantileSeconds(q));
+      }
+    }
+
+    out += "# HELP ahp_stage_duration_seconds Time spent in each processing stage.\n";
+    out += "# TYPE ahp_stage_duration_seconds histogram\n";
+    for (size_t s = 0; s < stageCount; s++) {
+      renderHistogram(out, "ahp_stage_duration_seconds", fmt::format("stage=\"{}\"", reg.stageNames[s]), stageLatency[s]);
+    }
+
+    return out;
+  }
+
+} // namespace metrics
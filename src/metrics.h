@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace metrics
+{
+  using Clock = std::chrono::steady_clock;
+  using MetricId = std::size_t;
+
+  constexpr std::size_t kMaxRoutes = 32;
+  constexpr std::size_t kMaxStages = 16;
+
+  // HDR-style log-linear histogram of nanosecond values: 2^kSubBucketBits sub-buckets per power of two, so values
+  // below 8ns are exact and larger ones are kept within 12.5% up to 2^(kMaxExponent + 1) - 1 ns (~36.6min).
+  // Longer values are counted in the last bucket, which caps their quantiles at ~36.6min; sumNs stays exact.
+  // Only the owning thread writes, scrapers read with relaxed loads.
+  class LatencyHistogram {
+  public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr std::size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    void record(std::uint64_t valueNs);
+
+    static std::size_t bucketIndex(std::uint64_t valueNs);
+    static std::uint64_t bucketUpperBound(std::size_t idx);   // inclusive, in ns
+
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets{};
+    std::atomic<std::uint64_t> sumNs{0};
+  };
+
+  // Registration happens while building the router, before any request is served.
+  MetricId registerRoute(const std::string& name);
+  MetricId registerStage(const std::string& name);
+
+  void recordRequest(MetricId route, Clock::duration latency, bool accepted);
+  void recordStage(MetricId stage, Clock::duration duration);
+
+  std::string renderPrometheus();   // text exposition format 0.0.4
+
+  // Records the lifetime of the enclosing scope as one stage observation
+  class StageTimer {
+  public:
+    explicit StageTimer(MetricId stage) : stage_(stage), start_(Clock::now()) {}
+    ~StageTimer() { recordStage(stage_, Clock::now() - start_); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+  private:
+    MetricId stage_;
+    Clock::time_point start_;
+  };
+
+  namespace stages {
+    // Stages of request processing, shared by all handlers
+    extern const MetricId parse;
+    extern const MetricId aggregate;
+    extern const MetricId rank;
+    extern const MetricId render;
+  } // namespace stages
+
+} // namespace metrics
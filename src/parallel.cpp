@@ -0,0 +1,88 @@
+#include "parallel.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+#define EIGEN_USE_THREADS
+#include <unsupported/Eigen/CXX11/ThreadPool>
+
+namespace parallel
+{
+  namespace {
+    int configuredThreads() {
+      if (const char* env = std::getenv("AHP_THREADS")) {
+        const int threads = std::atoi(env);
+        if (threads > 0)
+          return threads;
+      }
+      return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The caller takes part in every loop, so the pool holds one thread less than the configured count
+    Eigen::ThreadPool* pool() {
+      static const std::unique_ptr<Eigen::ThreadPool> instance = [] {
+        const int threads = configuredThreads();
+        return threads > 1 ? std::make_unique<Eigen::ThreadPool>(threads - 1) : nullptr;
+      }();
+      return instance.get();
+    }
+
+    thread_local bool drainingLoop = false;
+
+    // Marks the thread as inside a loop for the scope's lifetime, restoring the outer state after a nested loop
+    class LoopScope {
+    public:
+      LoopScope() : outer_(drainingLoop) { drainingLoop = true; }
+      ~LoopScope() { drainingLoop = outer_; }
+
+      LoopScope(const LoopScope&) = delete;
+      LoopScope& operator=(const LoopScope&) = delete;
+
+    private:
+      bool outer_;
+    };
+  }   // namespace
+
+  int threadCount() {
+    auto* workers = pool();
+    return workers ? workers->NumThreads() + 1 : 1;
+  }
+
+  int workerIndex() {
+    auto* workers = pool();
+    return workers ? workers->CurrentThreadId() + 1 : 0;
+  }
+
+  namespace detail {
+    bool insideLoop() {
+      return drainingLoop;
+    }
+
+    void run(Loop& loop, int helpers) {
+      auto* workers = pool();
+      Eigen::Barrier done(static_cast<unsigned>(helpers));
+      for (int h = 0; h < helpers; h++) {
+        // two pointers fit std::function's inline storage, scheduling does not allocate
+        workers->Schedule([&loop, &done] {
+          {
+            LoopScope scope;
+            loop.drain();
+          }
+          done.Notify();
+        });
+      }
+      {
+        LoopScope scope;
+        loop.drain();
+      }
+      done.Wait();
+      // the barrier orders the workers' writes of `error` before this read
+      if (loop.failed.load(std::memory_order_relaxed)) {
+        std::rethrow_exception(loop.error);
+      }
+    }
+  } // namespace detail
+
+} // namespace parallel
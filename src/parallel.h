@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#include <Eigen/Core>
+
+// Shared worker pool for the AHP computation core, an Eigen::ThreadPool (work-stealing NonBlockingThreadPool).
+// The thread count defaults to the hardware concurrency and can be set with the AHP_THREADS environment variable;
+// with a single thread every loop runs inline on the caller.
+namespace parallel
+{
+  // Loops cheaper than this many matrix cells run inline, scheduling would cost more than it saves
+  constexpr Eigen::Index kMinParallelCells = 1 << 14;
+
+  int threadCount();   // workers available to parallelFor, including the calling thread
+  // 0 outside the pool, 1 + the worker's id inside it; indexes per-thread buffers of a loop, threadCount() of them
+  int workerIndex();
+
+  namespace detail {
+    struct Loop {
+      std::atomic<Eigen::Index> next{0};
+      Eigen::Index count = 0;
+      const void* body = nullptr;
+      void (*invoke)(const void* body, Eigen::Index i) = nullptr;
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;   // the first exception thrown by body, written once by whoever set `failed`
+
+      // claims indices until none are left, so fast workers take over the tail of slow ones. An exception must not
+      // escape a pool worker: the first one is kept and the indices not yet claimed are given up.
+      void drain() {
+        for (Eigen::Index i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+          try {
+            invoke(body, i);
+          } catch (...) {
+            if (!failed.exchange(true, std::memory_order_relaxed)) {
+              error = std::current_exception();
+            }
+            next.store(count, std::memory_order_relaxed);
+          }
+        }
+      }
+    };
+
+    bool insideLoop();   // true while this thread, pool worker or caller, is draining a loop
+    // drains `loop` on the caller and `helpers` pool workers, waits for all of them and rethrows the first exception
+    void run(Loop& loop, int helpers);
+  } // namespace detail
+
+  // Calls body(i) for every i in [0, count), spread over the pool when count * cellsPerItem is worth it.
+  // Does not allocate; nested calls from inside a loop body run inline, on workers and on the caller alike. If body throws, the remaining indices may be skipped
+  // and the first exception is rethrown on the caller once every worker has left the loop.
+  template <typename Body>
+  void parallelFor(Eigen::Index count, Eigen::Index cellsPerItem, const Body& body) {
+    const int threads = threadCount();
+    if (count <= 1 || threads <= 1 || count * cellsPerItem < kMinParallelCells || detail::insideLoop()) {
+      for (Eigen::Index i = 0; i < count; i++) {
+        body(i);
+      }
+      return;
+    }
+
+    detail::Loop loop;
+    loop.count = count;
+    loop.body = &body;
+    loop.invoke = [](const void* b, Eigen::Index i) { (*static_cast<const Body*>(b))(i); };
+    detail::run(loop, static_cast<int>(std::min<Eigen::Index>(threads, count)) - 1);
+  }
+
+} // namespace parallel
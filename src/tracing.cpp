@@ -0,0 +1,178 @@
+#include "tracing.h"
+
+#include <array>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fmt/format.h>
+
+namespace tracing
+{
+  namespace {
+    constexpr std::size_t kMaxEventsPerThread = 1 << 20;
+    constexpr std::size_t kEventsPerChunk = 4096;
+
+    struct Event {
+      const char* name;
+      const char* category;
+      std::int64_t start;       // detail::now() units
+      std::int64_t duration;
+    };
+
+    // Only the owning thread writes events, without a lock. It publishes each one by storing `size` with release
+    // order and readers only look below the size they loaded. clear() moves `start` up to `size`; the owner then
+    // rewinds both to zero on its next span, reusing the chunks.
+    struct ThreadBuffer {
+      std::array<std::atomic<Event*>, kMaxEventsPerThread / kEventsPerChunk> chunks{};
+      std::atomic<std::size_t> size{0};
+      std::atomic<std::size_t> start{0};
+      std::atomic<std::uint64_t> dropped{0};
+      std::size_t tid = 0;
+
+      ThreadBuffer() = default;
+      ThreadBuffer(const ThreadBuffer&) = delete;
+      ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+      ~ThreadBuffer() {
+        for (auto& chunk : chunks)
+          delete[] chunk.load(std::memory_order_relaxed);
+      }
+
+      const Event& at(std::size_t index) const {
+        return chunks[index / kEventsPerChunk].load(std::memory_order_relaxed)[index % kEventsPerChunk];
+      }
+    };
+
+    struct Registry {
+      std::mutex mutex;
+      std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+      std::deque<std::string> internedNames;
+      const Clock::time_point epoch = Clock::now();
+      const std::int64_t epochTicks = detail::now();
+    };
+
+    Registry& registry() {
+      static Registry instance;
+      return instance;
+    }
+
+    ThreadBuffer& localBuffer() {
+      thread_local ThreadBuffer* buffer = [] {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+        reg.buffers.back()->tid = reg.buffers.size();
+        return reg.buffers.back().get();
+      }();
+      return *buffer;
+    }
+
+    void appendEscaped(std::string& out, const char* str) {
+      for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+          out += '\\';
+        out += *str;
+      }
+    }
+  }   // namespace
+
+  namespace detail {
+    std::atomic<bool> enabledFlag{false};
+
+    void record(const char* name, const char* category, std::int64_t start, std::int64_t end) {
+      auto& buffer = localBuffer();
+      std::size_t size = buffer.size.load(std::memory_order_relaxed);
+      if (size > 0 && buffer.start.load(std::memory_order_acquire) == size) {
+        buffer.size.store(0, std::memory_order_release);
+        buffer.start.store(0, std::memory_order_release);
+        size = 0;
+      }
+      if (size >= kMaxEventsPerThread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      auto& slot = buffer.chunks[size / kEventsPerChunk];
+      Event* chunk = slot.load(std::memory_order_relaxed);
+      if (!chunk) {
+        chunk = new Event[kEventsPerChunk];
+        slot.store(chunk, std::memory_order_relaxed);
+      }
+      chunk[size % kEventsPerChunk] = {name, category, start, end - start};
+      buffer.size.store(size + 1, std::memory_order_release);
+    }
+  } // namespace detail
+
+  void setEnabled(bool enabled) {
+    registry();   // pin the epoch before the first span
+    detail::enabledFlag.store(enabled, std::memory_order_relaxed);
+  }
+
+  const char* intern(const std::string& str) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (auto& name : reg.internedNames) {
+      if (name == str)
+        return name.c_str();
+    }
+    return reg.internedNames.emplace_back(str).c_str();
+  }
+
+  void clear() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (auto& buffer : reg.buffers) {
+      buffer->start.store(buffer->size.load(std::memory_order_acquire), std::memory_order_release);
+      buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::string renderChromeTrace() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+
+    // timestamps are scaled by the tick rate measured against the steady clock since the epoch
+    const double elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - reg.epoch).count();
+    const std::int64_t elapsedTicks = detail::now() - reg.epochTicks;
+    const double nsPerTick = elapsedTicks > 0 ? elapsedNs / elapsedTicks : 1.0;
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (auto& buffer : reg.buffers) {
+      const std::size_t start = buffer->start.load(std::memory_order_acquire);
+      const std::size_t size = buffer->size.load(std::memory_order_acquire);
+      for (std::size_t i = start; i < size; i++) {
+        const Event& event = buffer->at(i);
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"name\":\"";
+        appendEscaped(out, event.name);
+        out += "\",\"cat\":\"";
+        appendEscaped(out, event.category);
+        out += fmt::format("\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+          buffer->tid, (event.start - reg.epochTicks) * nsPerTick / 1000.0, event.duration * nsPerTick / 1000.0);
+      }
+      const std::uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+      if (dropped > 0) {
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += fmt::format("{{\"name\":\"dropped_spans\",\"ph\":\"C\",\"pid\":1,\"tid\":{},\"ts\":0,\"args\":{{\"count\":{}}}}}",
+          buffer->tid, dropped);
+      }
+    }
+    out += "\n]}\n";
+
+    return out;
+  }
+
+  void writeChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error("Could not open trace file: " + path);
+    }
+    file << renderChromeTrace();
+  }
+
+} // namespace tracing
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace tracing
+{
+  using Clock = std::chrono::steady_clock;
+
+  namespace detail {
+    extern std::atomic<bool> enabledFlag;
+
+    // Raw timestamp, scaled to ns when the trace is rendered. Reading the TSC costs half a steady_clock read, which
+    // matters for spans around kernels of a few microseconds.
+    inline std::int64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+      return static_cast<std::int64_t>(__rdtsc());
+#else
+      return Clock::now().time_since_epoch().count();
+#endif
+    }
+
+    void record(const char* name, const char* category, std::int64_t start, std::int64_t end);
+  } // namespace detail
+
+  inline bool enabled() {
+    return detail::enabledFlag.load(std::memory_order_relaxed);
+  }
+
+  void setEnabled(bool enabled);
+  const char* intern(const std::string& str);   // returns a pointer valid for the rest of the process
+  void clear();   // drops every recorded span
+
+  std::string renderChromeTrace();              // Chrome trace_event JSON of all recorded spans
+  void writeChromeTrace(const std::string& path);
+
+  // Records the lifetime of the enclosing scope as a complete ("X") event.
+  // Names and categories must outlive the trace, string literals are expected.
+  class Span {
+  public:
+    explicit Span(const char* name, const char* category = "ahp")
+      : name_(name), category_(category), start_(enabled() ? detail::now() : -1) {}
+
+    ~Span() {
+      if (start_ >= 0)
+        detail::record(name_, category_, start_, detail::now());
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+  private:
+    const char* name_;
+    const char* category_;
+    std::int64_t start_;
+  };
+
+} // namespace tracing
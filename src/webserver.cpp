@@ -1,9 +1,27 @@
 #include "webserver.h"
 #include "AHP.h"
+#include "ANP.h"
+#include "Diagnostics.h"
+#include "Fuzzy.h"
+#include "Hierarchy.h"
+#include "QuestionSelector.h"
+#include "RandomIndex.h"
+#include "Sensitivity.h"
+#include "Uncertainty.h"
 #include "logging.h"
 #include "json_handling.h"
+#include "metrics.h"
+#include "tracing.h"
 
+#include <restinio/helpers/http_field_parsers/bearer_auth.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 #include <mutex>
+#include <numeric>
+#include <optional>
 #include <filesystem>
 #include <fmt/core.h>
 
@@ -15,6 +33,16 @@ void createErrorResponse(auto& req, restinio::http_status_line_t status = restin
     .done();
 }
 
+// Invalid input: the reason goes back to the client, who can correct the request
+void createBadRequestResponse(auto& req, const std::string& message) {
+  req->create_response(restinio::status_bad_request())
+    .append_header( restinio::http_field::content_type, "application/json" )
+    .append_header_date_field()
+    .set_body(fmt::format("{{ \"status\": \"Error\", \"message\": {} }}", json_handling::quote(message)))
+    .connection_close()
+    .done();
+}
+
 void createOKResponse(auto& req) {
   req->create_response(restinio::status_ok())
     .append_header( restinio::http_field::content_type, "application/json" )
@@ -58,12 +86,96 @@ std::string getMIMEType(const restinio::string_view_t& ext)
 
 namespace webserver 
 {
+  constexpr size_t MaxBootstrapResamples = 100000;   // a bootstrap holds the state lock until it finishes
+  constexpr size_t MaxSimulations = 1000000;
+  constexpr size_t MaxDiagnosedJudgements = 100;   // each reported judgement is also tried as the fix, one lambda max
+  constexpr size_t MaxQuestionSessions = 4096;      // the least recently used session makes room for a new one
+  constexpr std::chrono::minutes QuestionSessionTtl{60};
+
+  // One agent's questionnaire, a comparison graph per criterion and one for the criteria
+  struct QuestionSession {
+    std::map<std::string, AHP::QuestionSelector> selectors;
+    std::chrono::steady_clock::time_point lastUsed;
+  };
+
+  using json_handling::number;
+  using json_handling::quote;
+
   static struct : public std::mutex { // just to make this object lockable
     std::vector<std::string> alternatives;
     std::vector<std::string> criteria;
-    std::vector<json_handling::AgentInput> agentInputs;
+    // Submissions as comparison graphs, [agent] and [criteria][agent]; complete ones are also aggregated incrementally
+    std::vector<AHP::SparseComparisons> critComparisons;
+    std::vector<std::vector<AHP::SparseComparisons>> altComparisons;
+    std::vector<double> agentWeights;
+    bool complete = true;                            // no submission left a pair out
+    std::optional<AHP::AHPMeanCalculator> aggregator;
+    std::optional<AHP::HierarchyMeanCalculator> hierarchy;   // surveys with sub-criteria; `criteria` then holds the leaves
+    std::optional<AHP::FuzzyMeanCalculator> fuzzy;            // surveys with a fuzzy spread, which take complete submissions only
+    AHP::PriorityMethod priorityMethod = AHP::PriorityMethod::GeometricMean;
+    AHP::AggregationMode aggregation = AHP::AggregationMode::Judgements;
+    AHP::RankingWorkspace rankingWorkspace;   // kept between results so the eigenvector method can warm-start
+    std::uint64_t revision = 0;               // bumped whenever the submissions or their weights change
+    std::optional<std::pair<std::uint64_t, AHP::PriorityMethod>> rankedAs;   // what rankingWorkspace holds the aggregate of
+    std::map<std::string, QuestionSession> questionSessions;
   } currentState;
 
+  Eigen::Index itemIndex(const std::vector<std::string>& items, const std::string& name) {
+    auto it = std::find(items.begin(), items.end(), name);
+    if(it == items.end()) {
+      throw std::invalid_argument("Unknown item: " + name);
+    }
+    return it - items.begin();
+  }
+
+  // Sizes of the survey's comparison matrices: criteria, alternatives and every inner node's children of a hierarchy;
+  // the caller holds the state lock
+  std::vector<Eigen::Index> surveyMatrixSizes() {
+    std::vector<Eigen::Index> sizes{static_cast<Eigen::Index>(currentState.criteria.size()),
+                                    static_cast<Eigen::Index>(currentState.alternatives.size())};
+    if(currentState.hierarchy) {
+      const auto& hierarchy = currentState.hierarchy->hierarchy();
+      for(Eigen::Index node : hierarchy.innerNodes()) {
+        sizes.push_back(hierarchy.childCount(node));
+      }
+    }
+    return sizes;
+  }
+
+  // Ranks the judgement aggregate of a complete survey into rankingWorkspace unless it already holds this revision
+  // ranked by `method`, so repeated analyses reuse its local weights; the caller holds the state lock
+  AHP::RankingWorkspace& rankedAggregate(AHP::PriorityMethod method, const char* analysis) {
+    if(!currentState.aggregator || currentState.critComparisons.empty()) {
+      throw std::invalid_argument(fmt::format("{} needs at least one submission and no incomplete ones", analysis));
+    }
+    const auto key = std::make_pair(currentState.revision, method);
+    if(currentState.rankedAs != key) {
+      AHP::Matrix2D critMatrix;
+      std::vector<AHP::Matrix2D> altMatrices;
+      {
+        metrics::StageTimer timer(metrics::stages::aggregate);
+        critMatrix = currentState.aggregator->getMeanCritMatrix();
+        altMatrices = currentState.aggregator->getMeanAltMatrices();
+      }
+      metrics::StageTimer timer(metrics::stages::rank);
+      auto& ws = currentState.rankingWorkspace;
+      currentState.rankedAs.reset();
+      AHP::AHPRanker(method).calculateRanking(critMatrix, altMatrices, ws);
+      if(ws.unconverged > 0) {
+        logger::error(fmt::format("{}: the eigenvector of {} matrices did not converge within the power iteration limit",
+                                  analysis, ws.unconverged));
+      }
+      // with sub-criteria the leaves' weights come from the hierarchy, the flat criteria matrix is a placeholder
+      if(currentState.hierarchy) {
+        ws.criteriaWeights = currentState.hierarchy->criteriaWeights(method);
+        ws.criteriaIRatio = currentState.hierarchy->criteriaIRatio(method);
+        ws.ranking.noalias() = ws.localWeights * ws.criteriaWeights;
+      }
+      currentState.rankedAs = key;
+    }
+    return currentState.rankingWorkspace;
+  }
+
   auto staticContentHandler = [](auto req, auto params) {
     const auto path = params["path"];
     const auto ext = params["ext"];
@@ -104,15 +216,65 @@ namespace webserver
       auto query = restinio::parse_query(req->header().query());
       std::string jsonStr(query["data"]);
 
-      auto [alternatives, criteria] = json_handling::parseSetup(jsonStr);
+      auto [alternatives, criteria, priorityMethod, aggregation, subcriteria, fuzzySpread] = [&] {
+        metrics::StageTimer timer(metrics::stages::parse);
+        return json_handling::parseSetup(jsonStr);
+      }();
 
       logger::debug(fmt::format("Recieved valid setup.\n\t criteria: [{}] \n\t alternatives: [{}]", 
                     fmt::join(criteria, ","), fmt::join(alternatives, ",")));
 
+      // alternatives are compared under the leaves of a hierarchy, which take the place of the criteria
+      std::optional<AHP::CriteriaHierarchy> hierarchy;
+      if(!subcriteria.empty()) {
+        if(fuzzySpread != 0.0) {
+          throw std::invalid_argument("Fuzzy surveys do not support sub-criteria");
+        }
+        hierarchy.emplace(criteria, subcriteria);
+        criteria = hierarchy->leaves();
+      }
+
+      // simulating RI for sizes beyond Saaty's table is a one-off, cached cost; pay it here rather than on /results
+      AHP::ensureRandomIndex(criteria.size(), priorityMethod);
+      AHP::ensureRandomIndex(alternatives.size(), priorityMethod);
+      if(hierarchy) {
+        for(Eigen::Index node : hierarchy->innerNodes()) {
+          AHP::ensureRandomIndex(hierarchy->childCount(node), priorityMethod);
+        }
+      }
+
+      // the new survey's calculators are built before the old survey is touched, a rejected setup leaves it as it was
+      std::optional<AHP::AHPMeanCalculator> aggregator(std::in_place, criteria);
+      std::optional<AHP::HierarchyMeanCalculator> hierarchyCalculator;
+      if(hierarchy) {
+        hierarchyCalculator.emplace(std::move(*hierarchy));
+      }
+      std::optional<AHP::FuzzyMeanCalculator> fuzzy;
+      if(fuzzySpread != 0.0) {
+        fuzzy.emplace(criteria.size(), alternatives.size(), fuzzySpread);
+      }
+
       std::lock_guard lock(currentState);
-      currentState.alternatives = alternatives;
-      currentState.criteria = criteria;
-      currentState.agentInputs.clear();
+      currentState.alternatives = std::move(alternatives);
+      currentState.criteria = std::move(criteria);
+      currentState.critComparisons.clear();
+      currentState.altComparisons.assign(currentState.criteria.size(), {});
+      currentState.agentWeights.clear();
+      currentState.complete = true;
+      currentState.aggregator = std::move(aggregator);
+      currentState.hierarchy = std::move(hierarchyCalculator);
+      currentState.fuzzy = std::move(fuzzy);
+      currentState.priorityMethod = priorityMethod;
+      currentState.aggregation = aggregation;
+      currentState.rankingWorkspace = AHP::RankingWorkspace();
+      currentState.revision++;
+      currentState.rankedAs.reset();
+      currentState.questionSessions.clear();
+    }
+    catch(const std::invalid_argument& e) {
+      logger::error(fmt::format("Rejected setup: {}\n\tquery: {}", e.what(), req->header().query()));
+      createBadRequestResponse(req, e.what());
+      return restinio::request_rejected();
     }
     catch(const std::exception& e) {
       logger::error(fmt::format("Error while parsing setup json: {}\n\tquery: {}", e.what(), req->header().query()));
@@ -124,20 +286,172 @@ namespace webserver
     return restinio::request_accepted();
   };
 
+  // Responds with the agent's index, which /setWeight uses to address the submission. Invalid submissions are rejected
+  // with a 400 and its reason before anything is stored.
   auto submitHandler = [](auto req, auto) {
+    size_t agent = 0;
     try {
       auto query = restinio::parse_query(req->header().query());
       std::string jsonStr(query["data"]);
 
-      json_handling::AgentInput agi = json_handling::parseAgentInput(jsonStr);
+      json_handling::AgentInput agi;
+      {
+        metrics::StageTimer timer(metrics::stages::parse);
+        agi = json_handling::parseAgentInput(jsonStr);
+      }
 
       logger::debug(fmt::format("Recieved valid agent input."));
 
       std::lock_guard lock(currentState);
-      currentState.agentInputs.push_back(agi);
+      metrics::StageTimer timer(metrics::stages::aggregate);
+      const size_t criteriaCount = currentState.criteria.size();
+      if(criteriaCount == 0) {
+        throw std::invalid_argument("No survey has been set up");
+      }
+      if(!std::isfinite(agi.weight) || agi.weight < 0.0) {
+        throw std::invalid_argument("Agent weight must be finite and non-negative");
+      }
+      for(auto& [criterion, comparisons] : agi.altComparisons) {
+        itemIndex(currentState.criteria, criterion);
+      }
+
+      // with sub-criteria the criteria are judged per node of the hierarchy and the flat criteria graph stays empty
+      std::map<Eigen::Index, AHP::Matrix2D> nodeMatrices;
+      AHP::SparseComparisons critComparisons;
+      if(currentState.hierarchy) {
+        nodeMatrices = AHP::buildNodeMatrices(currentState.hierarchy->hierarchy(), agi.critComparisons, agi.subcritComparisons);
+        critComparisons.n = static_cast<Eigen::Index>(criteriaCount);
+      } else {
+        critComparisons = AHP::buildSparseComparisons(agi.critComparisons, currentState.criteria);
+      }
+      std::vector<AHP::SparseComparisons> altComparisons;
+      bool complete = currentState.hierarchy || critComparisons.isComplete();
+      for(size_t i = 0; i < criteriaCount; i++) {
+        auto comparisons = agi.altComparisons.find(currentState.criteria[i]);
+        altComparisons.push_back(comparisons == agi.altComparisons.end()
+          ? AHP::SparseComparisons{static_cast<Eigen::Index>(currentState.alternatives.size()), {}}
+          : AHP::buildSparseComparisons(comparisons->second, currentState.alternatives));
+        complete = complete && altComparisons.back().isComplete();
+      }
+
+      // A survey is either aggregated as dense matrices, which influence, bootstrap, consensus and fuzzy ranking read,
+      // or ranked from its comparison graphs. An incomplete submission after complete ones would drop the aggregate,
+      // so it is refused; once the first submission left pairs out, complete ones are taken as graphs too.
+      if(!complete) {
+        if(currentState.hierarchy) {
+          throw std::invalid_argument("Surveys with sub-criteria take complete matrices only");
+        }
+        if(currentState.fuzzy) {
+          throw std::invalid_argument("Fuzzy surveys take complete matrices only");
+        }
+        if(currentState.complete && !currentState.critComparisons.empty()) {
+          throw std::invalid_argument("The survey's submissions so far are complete and aggregated as matrices; compare "
+                                      "every pair, or set up a new survey to collect incomplete submissions");
+        }
+      }
+
+      // the submission's entries are built aside and the survey's vectors have room for them; the fuzzy calculator also
+      // checks the judgements are on its scale and goes first, the others only check the weight and shapes, which hold
+      // by now, so once the survey starts to change only running out of memory could interrupt it
+      const bool aggregated = currentState.complete && complete;
+      AHP::Matrix2D agentCritMatrix;
+      std::map<std::string, AHP::Matrix2D> agentAltMatrices;
+      std::vector<AHP::Matrix2D> fuzzyAltMatrices;
+      if(aggregated) {
+        agentCritMatrix = AHP::toDense(critComparisons);
+        for(size_t i = 0; i < criteriaCount; i++) {
+          agentAltMatrices.emplace(currentState.criteria[i], AHP::toDense(altComparisons[i]));
+          if(currentState.fuzzy) {
+            fuzzyAltMatrices.push_back(agentAltMatrices.at(currentState.criteria[i]));
+          }
+        }
+      }
+      currentState.critComparisons.reserve(currentState.critComparisons.size() + 1);
+      for(size_t i = 0; i < criteriaCount; i++) {
+        currentState.altComparisons[i].reserve(currentState.altComparisons[i].size() + 1);
+      }
+      currentState.agentWeights.reserve(currentState.agentWeights.size() + 1);
+
+      if(aggregated && currentState.fuzzy) {
+        currentState.fuzzy->addAgent(agentCritMatrix, fuzzyAltMatrices, agi.weight);
+      }
+      if(currentState.hierarchy) {
+        currentState.hierarchy->addAgent(std::move(nodeMatrices), agi.weight);
+      }
+      if(aggregated) {
+        currentState.aggregator->addAgent(std::move(agentCritMatrix), std::move(agentAltMatrices), agi.weight);
+      } else {
+        currentState.aggregator.reset();
+      }
+      currentState.complete = aggregated;
+
+      agent = currentState.critComparisons.size();
+      currentState.critComparisons.push_back(std::move(critComparisons));
+      for(size_t i = 0; i < criteriaCount; i++) {
+        currentState.altComparisons[i].push_back(std::move(altComparisons[i]));
+      }
+      currentState.agentWeights.push_back(agi.weight);
+      currentState.revision++;
+    }
+    catch(const std::invalid_argument& e) {
+      logger::error(fmt::format("Rejected submission: {}\n\tquery: {}", e.what(), req->header().query()));
+      createBadRequestResponse(req, e.what());
+      return restinio::request_rejected();
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while parsing submission json: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(fmt::format("{{ \"status\": \"Success\", \"agent\": {} }}", agent))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Admin endpoint (see adminOnly): changes the expert weight of one submission, the aggregate is updated without reaggregation
+  auto setWeightHandler = [](auto req, auto) {
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      const auto update = json_handling::parseWeightUpdate(std::string(query["data"]));
+      if(!std::isfinite(update.weight) || update.weight < 0.0) {
+        throw std::invalid_argument("Agent weight must be finite and non-negative");
+      }
+
+      std::lock_guard lock(currentState);
+      if(update.agent >= currentState.agentWeights.size()) {
+        throw std::out_of_range(fmt::format("No agent {}", update.agent));
+      }
+      if(currentState.aggregator) {
+        currentState.aggregator->setWeight(update.agent, update.weight);
+      }
+      if(currentState.hierarchy) {
+        currentState.hierarchy->setWeight(update.agent, update.weight);
+      }
+      if(currentState.fuzzy) {
+        currentState.fuzzy->setWeight(update.agent, update.weight);
+      }
+      currentState.agentWeights[update.agent] = update.weight;
+      currentState.revision++;
+
+      logger::debug(fmt::format("Weight of agent {} set to {}", update.agent, update.weight));
+    }
+    catch(const std::invalid_argument& e) {
+      logger::error(fmt::format("Rejected agent weight: {}\n\tquery: {}", e.what(), req->header().query()));
+      createBadRequestResponse(req, e.what());
+      return restinio::request_rejected();
+    }
+    catch(const std::out_of_range& e) {
+      logger::error(fmt::format("Rejected agent weight: {}\n\tquery: {}", e.what(), req->header().query()));
+      createBadRequestResponse(req, e.what());
+      return restinio::request_rejected();
     }
     catch(const std::exception& e) {
-      logger::error(fmt::format("Error while parsing setup json: {}\n\tquery: {}", e.what(), req->header().query()));
+      logger::error(fmt::format("Error while setting agent weight: {}\n\tquery: {}", e.what(), req->header().query()));
       createErrorResponse(req);
       return restinio::request_rejected();
     }
@@ -146,11 +460,22 @@ namespace webserver
     return restinio::request_accepted();
   };
 
+  // `method` and `aggregation` rank the same data another way without changing the survey's defaults
   auto resultsHandler = [](auto req, auto) {
     try {
-      std::lock_guard lock(currentState);
+      auto query = restinio::parse_query(req->header().query());
+      std::unique_lock lock(currentState);
+
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      AHP::AggregationMode aggregation = currentState.aggregation;
+      if(query.has("aggregation")) {
+        aggregation = json_handling::parseAggregationMode(std::string(query["aggregation"]));
+      }
 
-      if(currentState.alternatives.empty() || currentState.criteria.empty() || currentState.agentInputs.empty()) {
+      if(currentState.alternatives.empty() || currentState.criteria.empty() || currentState.critComparisons.empty()) {
         req->create_response()
           .append_header( restinio::http_field::content_type, "application/json" )
           .append_header_date_field()
@@ -159,26 +484,51 @@ namespace webserver
         return restinio::request_rejected();
       }
 
-      AHP::AHPMeanCalculator meanCalc(currentState.criteria);
-
-      for(auto& agentInput : currentState.agentInputs) {
-        AHP::Matrix2D criteriaMatrix = AHP::buildMatrix(agentInput.critComparisons, currentState.criteria);
-        meanCalc.addCritMatrix(std::move(criteriaMatrix));
-
-        std::map<std::string, AHP::Matrix2D> altMatrices;
-        for(auto& [criteria, comparisons] : agentInput.altComparisons) {
-          altMatrices[criteria] = AHP::buildMatrix(comparisons, currentState.alternatives);
+      // random indices beyond Saaty's table are only missing when `method` overrides the setup's method; simulating
+      // them can take seconds, so the state is unlocked meanwhile. A setup racing in has simulated its own sizes.
+      {
+        const AHP::PriorityMethod ratioMethod = currentState.complete ? priorityMethod : AHP::PriorityMethod::LogLeastSquares;
+        const std::vector<Eigen::Index> sizes = surveyMatrixSizes();
+        lock.unlock();
+        for(Eigen::Index n : sizes) {
+          AHP::ensureRandomIndex(n, ratioMethod);
         }
-        meanCalc.addAltMatrices(std::move(altMatrices));
+        lock.lock();
       }
 
-      auto critMatrix = meanCalc.getMeanCritMatrix();
-      auto altMatrices = meanCalc.getMeanAltMatrices();
+      // Complete surveys read the incrementally maintained aggregate, or combine the agents' cached rankings when
+      // aggregating individual priorities; if any submission left a pair out the whole survey is ranked on its
+      // aggregated comparison graphs by logarithmic least squares, whatever the priority method and aggregation
+      const bool complete = currentState.complete;
+      const bool individual = complete && aggregation != AHP::AggregationMode::Judgements;
+      if(individual && currentState.hierarchy) {
+        throw std::invalid_argument("Aggregating individual priorities does not support sub-criteria");
+      }
+      AHP::SparseComparisons sparseCritMatrix;
+      std::vector<AHP::SparseComparisons> sparseAltMatrices;
+      if(!complete) {
+        metrics::StageTimer timer(metrics::stages::aggregate);
+        sparseCritMatrix = AHP::meanSparseComparisons(currentState.critComparisons, currentState.agentWeights);
+        for(auto& comparisons : currentState.altComparisons) {
+          sparseAltMatrices.push_back(AHP::meanSparseComparisons(comparisons, currentState.agentWeights));
+        }
+      }
 
-      AHP::AHPRanker ranker;
-      AHP::AHPResult result = ranker.calculateRanking(critMatrix, altMatrices);
+      AHP::AHPResult result;
+      if(complete && !individual) {
+        result = rankedAggregate(priorityMethod, "Ranking").result();
+      } else {
+        metrics::StageTimer timer(metrics::stages::rank);
+        if(individual) {
+          result = currentState.aggregator->getAggregatedPriorities(priorityMethod, aggregation);
+        } else {
+          result = AHP::calculateSparseRanking(sparseCritMatrix, sparseAltMatrices);
+        }
+      }
 
       // Prepare response
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      tracing::Span renderSpan("renderResults");
       std::string resp = loadFile("src_html/templates/results.html");
 
       // Ranking of alternatives
@@ -200,8 +550,9 @@ namespace webserver
       // Inconsistency ratios for alternatives
       std::string ir_alts = "";
       for(size_t i = 0; i < currentState.criteria.size(); i++) {
-        ir_alts += fmt::format("<tr><td class=\"ir-alt-data\">{}:</td> <td class=\"data-valcol\">{:.3}</td></tr>", 
-          currentState.criteria[i], result.alternativesIRatios[i]);
+        const double ratio = result.alternativesIRatios[i];
+        ir_alts += fmt::format("<tr><td class=\"ir-alt-data\">{}:</td> <td class=\"data-valcol\">{}</td></tr>", 
+          currentState.criteria[i], std::isnan(ratio) ? "N/A" : fmt::format("{:.3}", ratio));
       }
       resp.replace(resp.find("{{IR_ALTS}}"), 11, ir_alts);
 
@@ -225,12 +576,788 @@ namespace webserver
     return restinio::request_accepted();
   };
 
+  // Leave-one-out analysis of the judgement aggregate: how far the ranking and criteria weights would move without each
+  // agent, to spot outlier or manipulative respondents. `method` overrides the survey's priority method.
+  auto influenceHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      std::lock_guard lock(currentState);
+
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      if(!currentState.aggregator || currentState.critComparisons.empty()) {
+        throw std::invalid_argument("Influence needs at least one submission and no incomplete ones");
+      }
+      if(currentState.hierarchy) {
+        throw std::invalid_argument("Influence does not support sub-criteria");
+      }
+
+      std::vector<AHP::AgentInfluence> influence;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        influence = currentState.aggregator->leaveOneOut(priorityMethod);
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      std::vector<std::string> agents;
+      for(size_t agent = 0; agent < influence.size(); agent++) {
+        agents.push_back(fmt::format("{{ \"agent\": {}, \"weight\": {}, \"rankingShift\": {}, \"criteriaShift\": {}, "
+                                     "\"positionChanges\": {} }}", agent, number(currentState.agentWeights[agent]),
+                                     number(influence[agent].rankingShift), number(influence[agent].criteriaShift),
+                                     influence[agent].positionChanges));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"agents\": [{}] }}", fmt::join(agents, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing agent influence: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Bootstrap over the agents of a complete survey: weight intervals and rank-place probabilities per alternative.
+  // Optional `resamples` (default 1000), `confidence` (default 0.95), `seed` and `method`.
+  auto bootstrapHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      const size_t resamples = query.has("resamples") ? std::stoull(std::string(query["resamples"])) : 1000;
+      const double confidence = query.has("confidence") ? std::stod(std::string(query["confidence"])) : 0.95;
+      const std::uint64_t seed = query.has("seed") ? std::stoull(std::string(query["seed"])) : 1;
+      if(resamples == 0 || resamples > MaxBootstrapResamples) {
+        throw std::invalid_argument(fmt::format("resamples must be between 1 and {}", MaxBootstrapResamples));
+      }
+
+      std::lock_guard lock(currentState);
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      if(!currentState.aggregator || currentState.critComparisons.empty()) {
+        throw std::invalid_argument("Bootstrap needs at least one submission and no incomplete ones");
+      }
+      if(currentState.hierarchy) {
+        throw std::invalid_argument("Bootstrap does not support sub-criteria");
+      }
+
+      AHP::BootstrapResult result;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        result = currentState.aggregator->bootstrap(priorityMethod, resamples, confidence, seed);
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      std::vector<std::string> alternatives;
+      for(size_t i = 0; i < currentState.alternatives.size(); i++) {
+        const Eigen::VectorXd places = result.rankProbabilities.row(i);
+        alternatives.push_back(fmt::format("{{ \"name\": {}, \"lower\": {}, \"median\": {}, \"upper\": {}, "
+                                           "\"rankProbabilities\": [{}] }}", quote(currentState.alternatives[i]),
+                                           number(result.lower(i)), number(result.median(i)), number(result.upper(i)),
+                                           fmt::join(places, ", ")));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"resamples\": {}, \"confidence\": {}, \"alternatives\": [{}] }}",
+                         result.resamples, number(confidence), fmt::join(alternatives, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while bootstrapping results: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Rank reversal thresholds of every criterion weight for the judgement aggregate of a complete survey, in closed form:
+  // the weight intervals keeping the whole order and the top choice, the nearest swapping pair, and the weight change at
+  // which each alternative would overtake the top. `method` overrides the survey's priority method.
+  auto sensitivityHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      std::lock_guard lock(currentState);
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      const auto& ws = rankedAggregate(priorityMethod, "Sensitivity");
+      std::vector<AHP::CriterionSensitivity> sensitivity;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        sensitivity = AHP::criteriaSensitivity(ws.criteriaWeights, ws.localWeights);
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      const auto& names = currentState.alternatives;
+      Eigen::Index top = 0;
+      ws.ranking.maxCoeff(&top);
+
+      std::vector<std::string> criteria;
+      for(size_t k = 0; k < sensitivity.size(); k++) {
+        const auto& s = sensitivity[k];
+        const std::string critical = s.criticalFirst < 0 ? "null" :
+          fmt::format("{{ \"first\": {}, \"second\": {}, \"delta\": {} }}",
+                      quote(names[s.criticalFirst]), quote(names[s.criticalSecond]), number(s.criticalDelta));
+        std::vector<std::string> overtake;
+        for(size_t b = 0; b < names.size(); b++) {
+          if(static_cast<Eigen::Index>(b) != top) {
+            overtake.push_back(fmt::format("{}: {}", quote(names[b]), number(s.overtake(b))));
+          }
+        }
+        criteria.push_back(fmt::format("{{ \"name\": {}, \"weight\": {}, \"lower\": {}, \"upper\": {}, \"topLower\": {}, "
+                                       "\"topUpper\": {}, \"critical\": {}, \"overtake\": {{ {} }} }}",
+                                       quote(currentState.criteria[k]), number(s.weight), number(s.lower), number(s.upper),
+                                       number(s.topLower), number(s.topUpper), critical, fmt::join(overtake, ", ")));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"top\": {}, \"criteria\": [{}] }}",
+                         quote(names[top]), fmt::join(criteria, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing sensitivity: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Reranks a complete survey under criteria weights of the caller's choosing, for interactive what-if sliders. `data`
+  // holds either "criteriaWeights" (criterion -> weight; unnamed criteria keep their weight, the result is renormalized)
+  // or a "criteriaMatrix" replacing the aggregated one. The aggregate's local weights are cached per survey revision and
+  // method, so once they are ranked a request costs one matrix-vector product. `method` overrides the priority method.
+  auto whatIfHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      json_handling::WhatIfRequest request;
+      {
+        metrics::StageTimer timer(metrics::stages::parse);
+        request = json_handling::parseWhatIf(std::string(query["data"]));
+      }
+
+      std::lock_guard lock(currentState);
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      const auto& ws = rankedAggregate(priorityMethod, "What-if");
+
+      Eigen::VectorXd criteriaWeights = ws.criteriaWeights;
+      double criteriaIRatio = std::numeric_limits<double>::quiet_NaN();
+      Eigen::VectorXd ranking;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        if(!request.criteriaMatrix.empty()) {
+          const AHP::Matrix2D critMatrix = AHP::buildMatrix(request.criteriaMatrix, currentState.criteria);
+          Eigen::VectorXd products(critMatrix.rows());
+          const double lambda = AHP::lambdaMax(critMatrix, priorityMethod, criteriaWeights, products);
+          criteriaIRatio = AHP::consistencyRatio(lambda, critMatrix.rows(), priorityMethod);
+        } else {
+          for(auto& [criterion, weight] : request.criteriaWeights) {
+            if(!std::isfinite(weight) || weight < 0.0) {
+              throw std::invalid_argument("Criteria weights must be finite and non-negative");
+            }
+            criteriaWeights(itemIndex(currentState.criteria, criterion)) = weight;
+          }
+          const double sum = criteriaWeights.sum();
+          if(!(sum > 0.0)) {
+            throw std::invalid_argument("Criteria weights must not all be zero");
+          }
+          criteriaWeights /= sum;
+        }
+        ranking.noalias() = ws.localWeights * criteriaWeights;
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      std::vector<std::string> weights;
+      for(size_t k = 0; k < currentState.criteria.size(); k++) {
+        weights.push_back(fmt::format("{}: {}", quote(currentState.criteria[k]), number(criteriaWeights(k))));
+      }
+      std::vector<Eigen::Index> order(ranking.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](Eigen::Index a, Eigen::Index b) { return ranking(a) > ranking(b); });
+      std::vector<std::string> alternatives;
+      for(Eigen::Index a : order) {
+        alternatives.push_back(fmt::format("{{ \"name\": {}, \"weight\": {} }}", quote(currentState.alternatives[a]),
+                                           number(ranking(a))));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"criteriaWeights\": {{ {} }}, \"criteriaIRatio\": {}, "
+                         "\"ranking\": [{}] }}", fmt::join(weights, ", "), number(criteriaIRatio), fmt::join(alternatives, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing what-if ranking: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Group consensus of a complete survey: per matrix the geometric cardinal consensus index (GCCI), the mean and the
+  // largest spread of the agents' log judgements. Reads the running moments kept with the aggregate, O(criteria * n^2)
+  // whatever the panel size. `agent` adds that agent's RMS log distance to the group judgements per matrix.
+  auto consensusHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      std::optional<size_t> agent;
+      if(query.has("agent")) {
+        agent = std::stoull(std::string(query["agent"]));
+      }
+
+      std::lock_guard lock(currentState);
+      if(!currentState.aggregator || currentState.critComparisons.empty()) {
+        throw std::invalid_argument("Consensus needs at least one submission and no incomplete ones");
+      }
+      std::vector<AHP::MatrixConsensus> consensus;
+      Eigen::VectorXd distances;
+      {
+        metrics::StageTimer timer(metrics::stages::aggregate);
+        consensus = currentState.aggregator->consensus();
+        if(agent) {
+          distances = currentState.aggregator->agentDistances(*agent);
+        }
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      auto render = [&](const AHP::MatrixConsensus& matrix, const std::vector<std::string>& items) {
+        const std::string widest = matrix.maxI == matrix.maxJ ? "null"
+          : fmt::format("{{ \"first\": {}, \"second\": {}, \"value\": {} }}", quote(items[matrix.maxI]),
+                        quote(items[matrix.maxJ]), number(matrix.maxDispersion));
+        return fmt::format("{{ \"gcci\": {}, \"dispersion\": {}, \"maxDispersion\": {} }}", number(matrix.gcci),
+                           number(matrix.dispersion), widest);
+      };
+      // with sub-criteria the flat criteria matrix is a placeholder
+      const std::string criteria = currentState.hierarchy ? "null" : render(consensus[0], currentState.criteria);
+      std::vector<std::string> alternatives, agentAlternatives;
+      for(size_t i = 0; i < currentState.criteria.size(); i++) {
+        alternatives.push_back(fmt::format("{}: {}", quote(currentState.criteria[i]), render(consensus[1 + i], currentState.alternatives)));
+        if(agent) {
+          agentAlternatives.push_back(fmt::format("{}: {}", quote(currentState.criteria[i]), number(distances(1 + i))));
+        }
+      }
+      std::string agentDistance;
+      if(agent) {
+        agentDistance = fmt::format(", \"agentDistance\": {{ \"agent\": {}, \"criteria\": {}, \"alternatives\": {{ {} }} }}", *agent,
+                                    currentState.hierarchy ? "null" : number(distances(0)), fmt::join(agentAlternatives, ", "));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"agents\": {}, \"criteria\": {}, \"alternatives\": {{ {} }}{} }}",
+                         currentState.critComparisons.size(), criteria, fmt::join(alternatives, ", "), agentDistance);
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing consensus: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Fuzzy AHP ranking of a survey set up with a "fuzzySpread", next to the crisp ranking of the same judgements so
+  // the two can be compared. Alternatives carry their triangular score (lower, modal, upper) and the defuzzified
+  // centroid they are sorted by. `method` sets the priority method of the crisp ranking.
+  auto fuzzyHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      std::lock_guard lock(currentState);
+      if(!currentState.fuzzy) {
+        throw std::invalid_argument("Fuzzy ranking needs a survey set up with a fuzzySpread");
+      }
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      const auto& ws = rankedAggregate(priorityMethod, "Fuzzy ranking");
+
+      AHP::FuzzyResult fuzzy;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        fuzzy = currentState.fuzzy->rank();
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      auto sorted = [](const Eigen::VectorXd& scores) {
+        std::vector<Eigen::Index> order(scores.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](Eigen::Index a, Eigen::Index b) { return scores(a) > scores(b); });
+        return order;
+      };
+      std::vector<std::string> crisp;
+      for(Eigen::Index a : sorted(ws.ranking)) {
+        crisp.push_back(fmt::format("{{ \"name\": {}, \"weight\": {} }}", quote(currentState.alternatives[a]), number(ws.ranking(a))));
+      }
+      std::vector<std::string> criteria;
+      for(size_t k = 0; k < currentState.criteria.size(); k++) {
+        criteria.push_back(fmt::format("{}: {{ \"lower\": {}, \"modal\": {}, \"upper\": {} }}", quote(currentState.criteria[k]),
+                                       number(fuzzy.criteria.lower(k)), number(fuzzy.criteria.modal(k)),
+                                       number(fuzzy.criteria.upper(k))));
+      }
+      std::vector<std::string> alternatives;
+      for(Eigen::Index a : sorted(fuzzy.defuzzified)) {
+        alternatives.push_back(fmt::format("{{ \"name\": {}, \"lower\": {}, \"modal\": {}, \"upper\": {}, \"defuzzified\": {} }}",
+                                           quote(currentState.alternatives[a]), number(fuzzy.ranking.lower(a)),
+                                           number(fuzzy.ranking.modal(a)), number(fuzzy.ranking.upper(a)),
+                                           number(fuzzy.defuzzified(a))));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"spread\": {}, \"crispRanking\": [{}], \"criteriaWeights\": {{ {} }}, "
+                         "\"ranking\": [{}] }}", number(currentState.fuzzy->spread()), fmt::join(crisp, ", "), fmt::join(criteria, ", "),
+                         fmt::join(alternatives, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing fuzzy ranking: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Consistency diagnostics of a respondent's judgements before (or instead of) submitting them: `data` is a submission
+  // as /submit takes it, every complete matrix in it gets its `top` (default 5) most inconsistent judgements with the
+  // worst triad and a suggested value, and the one change that lowers its CR most. Matrices above
+  // AHP::ExactTriadsUpTo items are scored on AHP::TriadSamples third items unless `samples` says otherwise (0 for all).
+  auto diagnosticsHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      const size_t top = query.has("top") ? std::stoull(std::string(query["top"])) : 5;
+      if(top == 0 || top > MaxDiagnosedJudgements) {
+        throw std::invalid_argument(fmt::format("top must be between 1 and {}", MaxDiagnosedJudgements));
+      }
+      std::optional<Eigen::Index> samples;
+      if(query.has("samples")) {
+        samples = std::stoll(std::string(query["samples"]));
+      }
+      json_handling::AgentInput agi;
+      {
+        metrics::StageTimer timer(metrics::stages::parse);
+        agi = json_handling::parseAgentInput(std::string(query["data"]));
+      }
+
+      // what each matrix compares, named like the survey; the diagnosis itself does not need the state lock
+      struct Diagnosed {
+        const char* kind;
+        std::string criterion;
+        std::vector<std::string> items;
+        const AHP::Comparisons* comparisons;
+      };
+      std::vector<Diagnosed> matrices;
+      AHP::PriorityMethod priorityMethod;
+      {
+        std::lock_guard lock(currentState);
+        if(currentState.criteria.empty()) {
+          throw std::invalid_argument("Diagnostics need a survey setup");
+        }
+        priorityMethod = currentState.priorityMethod;
+        if(currentState.hierarchy) {
+          const auto& hierarchy = currentState.hierarchy->hierarchy();
+          if(!agi.critComparisons.empty()) {
+            matrices.push_back({"criteria", "", hierarchy.childNames(0), &agi.critComparisons});
+          }
+          for(auto& [parent, comparisons] : agi.subcritComparisons) {
+            matrices.push_back({"subcriteria", parent, hierarchy.childNames(hierarchy.node(parent)), &comparisons});
+          }
+        } else if(!agi.critComparisons.empty()) {
+          matrices.push_back({"criteria", "", currentState.criteria, &agi.critComparisons});
+        }
+        for(auto& [criterion, comparisons] : agi.altComparisons) {
+          itemIndex(currentState.criteria, criterion);
+          matrices.push_back({"alternatives", criterion, currentState.alternatives, &comparisons});
+        }
+      }
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+
+      std::vector<std::string> rendered;
+      for(auto& matrix : matrices) {
+        const AHP::SparseComparisons sparse = AHP::buildSparseComparisons(*matrix.comparisons, matrix.items);
+        const std::string criterion = matrix.criterion.empty() ? "null" : quote(matrix.criterion);
+        if(!sparse.isComplete()) {
+          rendered.push_back(fmt::format("{{ \"kind\": \"{}\", \"criterion\": {}, \"complete\": false }}", matrix.kind, criterion));
+          continue;
+        }
+
+        AHP::ConsistencyDiagnostics diagnostics;
+        {
+          metrics::StageTimer timer(metrics::stages::rank);
+          const Eigen::Index n = sparse.n;
+          AHP::ensureRandomIndex(n, priorityMethod);
+          diagnostics = AHP::diagnoseConsistency(AHP::toDense(sparse), priorityMethod, top,
+                                                 samples.value_or(n > AHP::ExactTriadsUpTo ? AHP::TriadSamples : 0));
+        }
+
+        metrics::StageTimer renderTimer(metrics::stages::render);
+        std::vector<std::string> judgements;
+        for(auto& judgement : diagnostics.judgements) {
+          judgements.push_back(fmt::format("{{ \"first\": {}, \"second\": {}, \"value\": {}, \"inconsistency\": {}, "
+                                           "\"worstTriad\": {{ \"third\": {}, \"value\": {} }}, \"suggested\": {} }}",
+                                           quote(matrix.items[judgement.i]), quote(matrix.items[judgement.j]),
+                                           number(judgement.value), number(judgement.inconsistency),
+                                           quote(matrix.items[judgement.worstThird]), number(judgement.worstTriad),
+                                           number(judgement.suggested)));
+        }
+        std::string fix = "null";
+        if(diagnostics.bestFix) {
+          const auto& judgement = diagnostics.judgements[*diagnostics.bestFix];
+          fix = fmt::format("{{ \"first\": {}, \"second\": {}, \"from\": {}, \"to\": {}, \"iRatio\": {} }}",
+                            quote(matrix.items[judgement.i]), quote(matrix.items[judgement.j]), number(judgement.value),
+                            number(judgement.suggested), number(diagnostics.fixedIRatio));
+        }
+        rendered.push_back(fmt::format("{{ \"kind\": \"{}\", \"criterion\": {}, \"complete\": true, \"iRatio\": {}, "
+                                       "\"thirdItems\": {}, \"judgements\": [{}], \"fix\": {} }}", matrix.kind, criterion,
+                                       number(diagnostics.iRatio), diagnostics.thirdItems, fmt::join(judgements, ", "), fix));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"matrices\": [{}] }}", fmt::join(rendered, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while diagnosing consistency: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Analytic network process on the network in `data`, independent of the survey: limit priorities of every node and
+  // their shares within each cluster. `method` sets how the pairwise matrices are weighted (default geometricMean).
+  auto anpHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      AHP::PriorityMethod priorityMethod = AHP::PriorityMethod::GeometricMean;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+
+      AHP::NetworkModel model;
+      {
+        metrics::StageTimer timer(metrics::stages::parse);
+        auto network = json_handling::parseNetwork(std::string(query["data"]));
+        model = AHP::buildNetworkModel(network.clusters, network.nodeComparisons, network.clusterComparisons);
+      }
+      for(const auto* blocks : {&model.nodeBlocks, &model.clusterBlocks}) {
+        for(auto& block : *blocks) {
+          AHP::ensureRandomIndex(block.matrix.rows(), priorityMethod);
+        }
+      }
+
+      AHP::Supermatrix supermatrix;
+      {
+        metrics::StageTimer timer(metrics::stages::aggregate);
+        supermatrix = AHP::buildSupermatrix(model, priorityMethod);
+      }
+      AHP::LimitPriorities limit;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        limit = AHP::limitPriorities(supermatrix.weighted);
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      std::vector<std::string> clusters;
+      for(size_t c = 0; c < model.clusters.size(); c++) {
+        const Eigen::Index begin = model.clusterBegin[c], end = model.clusterBegin[c + 1];
+        const double share = limit.priorities.segment(begin, end - begin).sum();
+        std::vector<std::string> nodes;
+        for(Eigen::Index node = begin; node < end; node++) {
+          nodes.push_back(fmt::format("{{ \"name\": {}, \"limit\": {}, \"normalized\": {} }}", quote(model.nodes[node]),
+                                      number(limit.priorities(node)), number(limit.priorities(node) / share)));
+        }
+        clusters.push_back(fmt::format("{{ \"name\": {}, \"nodes\": [{}] }}", quote(model.clusters[c]), fmt::join(nodes, ", ")));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"converged\": {}, \"iterations\": {}, \"period\": {}, "
+                         "\"maxIRatio\": {}, \"clusters\": [{}] }}", limit.period > 0, limit.iterations, limit.period,
+                         number(supermatrix.maxIRatio), fmt::join(clusters, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while computing network priorities: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Monte Carlo rank stability of a complete survey under judgement noise on the aggregated matrices. Optional
+  // `simulations` (default 10000), `noise` (saatyStep, the default, or logNormal), `sigma` (default 0.1), `seed`, `method`.
+  auto uncertaintyHandler = [](auto req, auto) {
+    std::string body;
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      const size_t simulations = query.has("simulations") ? std::stoull(std::string(query["simulations"])) : 10000;
+      const AHP::JudgementNoise noise = query.has("noise") ? json_handling::parseJudgementNoise(std::string(query["noise"]))
+                                                            : AHP::JudgementNoise::SaatyStep;
+      const double sigma = query.has("sigma") ? std::stod(std::string(query["sigma"])) : 0.1;
+      const std::uint64_t seed = query.has("seed") ? std::stoull(std::string(query["seed"])) : 1;
+      if(simulations == 0 || simulations > MaxSimulations) {
+        throw std::invalid_argument(fmt::format("simulations must be between 1 and {}", MaxSimulations));
+      }
+
+      std::lock_guard lock(currentState);
+      AHP::PriorityMethod priorityMethod = currentState.priorityMethod;
+      if(query.has("method")) {
+        priorityMethod = json_handling::parsePriorityMethod(std::string(query["method"]));
+      }
+      if(!currentState.aggregator || currentState.critComparisons.empty()) {
+        throw std::invalid_argument("Uncertainty simulation needs at least one submission and no incomplete ones");
+      }
+      if(currentState.hierarchy) {
+        throw std::invalid_argument("Uncertainty simulation does not support sub-criteria");
+      }
+
+      AHP::Matrix2D critMatrix;
+      std::vector<AHP::Matrix2D> altMatrices;
+      {
+        metrics::StageTimer timer(metrics::stages::aggregate);
+        critMatrix = currentState.aggregator->getMeanCritMatrix();
+        altMatrices = currentState.aggregator->getMeanAltMatrices();
+      }
+      AHP::UncertaintyResult result;
+      {
+        metrics::StageTimer timer(metrics::stages::rank);
+        result = AHP::simulateJudgementUncertainty(critMatrix, altMatrices, priorityMethod, noise, sigma, simulations, seed);
+      }
+
+      metrics::StageTimer renderTimer(metrics::stages::render);
+      std::vector<std::string> alternatives;
+      for(size_t i = 0; i < currentState.alternatives.size(); i++) {
+        const Eigen::VectorXd places = result.rankProbabilities.row(i);
+        alternatives.push_back(fmt::format("{{ \"name\": {}, \"meanWeight\": {}, \"stdDevWeight\": {}, \"stability\": {}, "
+                                           "\"rankProbabilities\": [{}] }}", quote(currentState.alternatives[i]),
+                                           number(result.meanWeight(i)), number(result.stdDevWeight(i)),
+                                           number(result.stability(i)), fmt::join(places, ", ")));
+      }
+      body = fmt::format("{{ \"status\": \"Success\", \"simulations\": {}, \"alternatives\": [{}] }}",
+                         result.simulations, fmt::join(alternatives, ", "));
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while simulating judgement uncertainty: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    req->create_response(restinio::status_ok())
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .connection_close()
+      .done();
+    return restinio::request_accepted();
+  };
+
+  // Suggests the next pair an agent should compare, so that large matrices need far fewer than n(n-1)/2 judgements.
+  // Sessions keep their comparison graph, each call only sends the judgements given since the previous one. A session
+  // idle for QuestionSessionTtl is dropped and its agent starts over with the judgements sent next.
+  auto nextQuestionHandler = [](auto req, auto) {
+    try {
+      auto query = restinio::parse_query(req->header().query());
+      std::string jsonStr(query["data"]);
+
+      json_handling::QuestionRequest request;
+      {
+        metrics::StageTimer timer(metrics::stages::parse);
+        request = json_handling::parseQuestionRequest(jsonStr);
+      }
+
+      std::lock_guard lock(currentState);
+      const bool forCriteria = request.criterion.empty();
+      if(!forCriteria) {
+        itemIndex(currentState.criteria, request.criterion);
+      }
+      const auto& items = forCriteria ? currentState.criteria : currentState.alternatives;
+
+      // every answered pair is resolved before the session changes, so an unknown item leaves it as it was
+      std::vector<std::pair<Eigen::Index, Eigen::Index>> answered;
+      for(auto& [item1, values] : request.answered) {
+        const Eigen::Index i = itemIndex(items, item1);
+        for(auto& [item2, value] : values) {
+          answered.emplace_back(i, itemIndex(items, item2));
+        }
+      }
+
+      // idle sessions expire; at the cap a new session evicts the least recently used one
+      auto& sessions = currentState.questionSessions;
+      const auto now = std::chrono::steady_clock::now();
+      std::erase_if(sessions, [&](const auto& entry) {
+        return entry.first != request.session && now - entry.second.lastUsed > QuestionSessionTtl;
+      });
+      if(sessions.size() >= MaxQuestionSessions && !sessions.contains(request.session)) {
+        sessions.erase(std::min_element(sessions.begin(), sessions.end(), [](const auto& a, const auto& b) {
+          return a.second.lastUsed < b.second.lastUsed;
+        }));
+      }
+      auto& session = sessions[request.session];
+      session.lastUsed = now;
+
+      auto& selector = session.selectors.try_emplace(request.criterion, static_cast<Eigen::Index>(items.size())).first->second;
+      for(auto [i, j] : answered) {
+        selector.addJudgement(i, j);
+      }
+      const auto pair = selector.next();
+      const std::string pairJson = pair ? fmt::format("[{}, {}]", quote(items[pair->first]), quote(items[pair->second])) : "null";
+      const size_t total = items.size() * (items.size() - 1) / 2;
+
+      req->create_response()
+        .append_header( restinio::http_field::content_type, "application/json" )
+        .append_header_date_field()
+        .set_body(fmt::format("{{ \"status\": \"Success\", \"pair\": {}, \"judged\": {}, \"total\": {}, "
+                              "\"connected\": {}, \"algebraicConnectivity\": {} }}",
+          pairJson, selector.judged(), total, selector.components() <= 1, number(selector.algebraicConnectivity())))
+        .done();
+    }
+    catch(const std::invalid_argument& e) {
+      logger::error(fmt::format("Rejected question request: {}\n\tquery: {}", e.what(), req->header().query()));
+      createBadRequestResponse(req, e.what());
+      return restinio::request_rejected();
+    }
+    catch(const std::exception& e) {
+      logger::error(fmt::format("Error while selecting next question: {}\n\tquery: {}", e.what(), req->header().query()));
+      createErrorResponse(req);
+      return restinio::request_rejected();
+    }
+
+    return restinio::request_accepted();
+  };
+
+  auto metricsHandler = [](auto req, auto) {
+    req->create_response()
+      .append_header( restinio::http_field::content_type, "text/plain; version=0.0.4; charset=utf-8" )
+      .append_header_date_field()
+      .set_body(metrics::renderPrometheus())
+      .done();
+
+    return restinio::request_accepted();
+  };
+
+  // Admin endpoint (see adminOnly): dumps recorded spans as Chrome trace JSON, `enable` toggles recording and `clear` drops the buffers after the dump
+  auto traceHandler = [](auto req, auto) {
+    auto query = restinio::parse_query(req->header().query());
+
+    if(query.has("enable")) {
+      tracing::setEnabled(query["enable"] == "1" || query["enable"] == "true");
+    }
+
+    std::string body = tracing::renderChromeTrace();
+    if(query.has("clear")) {
+      tracing::clear();
+    }
+
+    req->create_response()
+      .append_header( restinio::http_field::content_type, "application/json" )
+      .append_header_date_field()
+      .set_body(std::move(body))
+      .done();
+
+    return restinio::request_accepted();
+  };
+
+  // Set once from AHP_ADMIN_TOKEN; empty disables the admin routes
+  const std::string& adminToken() {
+    static const std::string token = [] {
+      const char* env = std::getenv("AHP_ADMIN_TOKEN");
+      return std::string(env ? env : "");
+    }();
+    return token;
+  }
+
+  // Compares every byte whatever the first mismatch, so response times do not reveal a prefix of the token
+  bool tokenMatches(const std::string& given, const std::string& expected) {
+    if(given.size() != expected.size()) {
+      return false;
+    }
+    unsigned char diff = 0;
+    for(size_t i = 0; i < given.size(); i++) {
+      diff |= static_cast<unsigned char>(given[i] ^ expected[i]);
+    }
+    return diff == 0;
+  }
+
+  // Wraps an admin route handler: 403 unless AHP_ADMIN_TOKEN is set and sent as "Authorization: Bearer <token>"
+  auto adminOnly(auto handler) {
+    return [handler](auto req, auto params) {
+      namespace bearer = restinio::http_field_parsers::bearer_auth;
+      const auto auth = bearer::try_extract_params(*req, restinio::http_field::authorization);
+      if(adminToken().empty() || !auth || !tokenMatches(auth->token, adminToken())) {
+        logger::error(fmt::format("Forbidden admin request: {}", req->header().path()));
+        createErrorResponse(req, restinio::status_forbidden());
+        return restinio::request_rejected();
+      }
+      return handler(std::move(req), std::move(params));
+    };
+  }
+
+  // Wraps a route handler so that its latency and outcome are recorded under `route`
+  auto instrumented(const std::string& route, auto handler) {
+    const metrics::MetricId id = metrics::registerRoute(route);
+    const char* spanName = tracing::intern(route);
+    return [id, spanName, handler](auto req, auto params) {
+      tracing::Span span(spanName, "http");
+      const auto start = metrics::Clock::now();
+      const auto status = handler(std::move(req), std::move(params));
+      metrics::recordRequest(id, metrics::Clock::now() - start, status == restinio::request_accepted());
+      return status;
+    };
+  }
+
   std::unique_ptr<router_t> createRequestHandler()
   {
     auto router = std::make_unique<router_t>();
     router->http_get(
       "/",
-      [](auto req, auto) {
+      instrumented("index", [](auto req, auto) {
         req->create_response()
         .append_header( restinio::http_field::content_type, "text/html; charset=utf-8" )
         .append_header_date_field()
@@ -238,23 +1365,75 @@ namespace webserver
         .done();
 
         return restinio::request_accepted();
-      }
+      })
     );
     router->http_get(
       "/submitSetup",
-      submitSetupHandler
+      instrumented("submitSetup", submitSetupHandler)
     );
     router->http_get(
       "/submit",
-      submitHandler
+      instrumented("submit", submitHandler)
+    );
+    router->http_get(
+      "/setWeight",
+      instrumented("setWeight", adminOnly(setWeightHandler))
     );
     router->http_get(
       "/results",
-      resultsHandler
+      instrumented("results", resultsHandler)
+    );
+    router->http_get(
+      "/influence",
+      instrumented("influence", influenceHandler)
+    );
+    router->http_get(
+      "/bootstrap",
+      instrumented("bootstrap", bootstrapHandler)
+    );
+    router->http_get(
+      "/sensitivity",
+      instrumented("sensitivity", sensitivityHandler)
+    );
+    router->http_get(
+      "/whatif",
+      instrumented("whatif", whatIfHandler)
+    );
+    router->http_get(
+      "/consensus",
+      instrumented("consensus", consensusHandler)
+    );
+    router->http_get(
+      "/fuzzy",
+      instrumented("fuzzy", fuzzyHandler)
+    );
+    router->http_get(
+      "/diagnostics",
+      instrumented("diagnostics", diagnosticsHandler)
+    );
+    router->http_get(
+      "/anp",
+      instrumented("anp", anpHandler)
+    );
+    router->http_get(
+      "/uncertainty",
+      instrumented("uncertainty", uncertaintyHandler)
+    );
+    router->http_get(
+      "/nextQuestion",
+      instrumented("nextQuestion", nextQuestionHandler)
+    );
+    router->http_get(
+      "/metrics",
+      instrumented("metrics", metricsHandler)
+    );
+    router->http_get(
+      "/trace",
+      instrumented("trace", adminOnly(traceHandler))
     );
     router->http_get(
       R"(/static/:path(.*)\.:ext(.*))",
-      staticContentHandler
+      instrumented("static", staticContentHandler)
     );
 
     return router;
@@ -0,0 +1,203 @@
+#include "test_utils.h"
+#include "AHP.h"
+#include "ANP.h"
+#include "Fuzzy.h"
+#include "QuestionSelector.h"
+#include "Sensitivity.h"
+
+#include <cmath>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <vector>
+
+// Correctness against values known in closed form
+namespace
+{
+  AHP::Matrix2D consistentMatrix(const Eigen::VectorXd& weights) {
+    return weights * weights.cwiseInverse().transpose();   // a_ij = w_i / w_j
+  }
+
+  // every priority method recovers the weights of a consistent matrix, whose CR is 0
+  void consistentMatrixWeights() {
+    Eigen::VectorXd criteria(4), alternatives(3);
+    criteria << 0.4, 0.3, 0.2, 0.1;
+    alternatives << 0.5, 0.3, 0.2;
+    const std::vector<AHP::Matrix2D> altMatrices(4, consistentMatrix(alternatives));
+
+    for (auto method : {AHP::PriorityMethod::Eigenvector, AHP::PriorityMethod::GeometricMean}) {
+      AHP::RankingWorkspace ws;
+      AHP::AHPRanker(method).calculateRanking(consistentMatrix(criteria), altMatrices, ws);
+      test::check(ws.criteriaWeights.isApprox(criteria, 1e-9), "consistent criteria weights");
+      test::check(ws.ranking.isApprox(alternatives, 1e-9), "consistent ranking");
+      test::checkNear(ws.criteriaIRatio, 0.0, 1e-9, "CR of a consistent matrix");
+    }
+  }
+
+  // on a complete, inconsistent matrix the logarithmic least squares priorities are the row geometric means
+  void logLeastSquaresOnFullGraph() {
+    AHP::Matrix2D matrix(4, 4);
+    matrix << 1.0,     3.0,     5.0,     1.0 / 2,
+              1.0 / 3, 1.0,     4.0,     1.0 / 7,
+              1.0 / 5, 1.0 / 4, 1.0,     1.0 / 9,
+              2.0,     7.0,     9.0,     1.0;
+    AHP::SparseComparisons sparse{4, {}};
+    for (Eigen::Index i = 0; i < 4; i++) {
+      for (Eigen::Index j = i + 1; j < 4; j++) {
+        sparse.judgements.push_back({i, j, matrix(i, j)});
+      }
+    }
+
+    Eigen::VectorXd geometric = matrix.array().log().rowwise().mean().exp().matrix();
+    geometric /= geometric.sum();
+    Eigen::VectorXd sparseWeights = AHP::sparseLogLeastSquaresWeights(sparse);
+    sparseWeights /= sparseWeights.sum();
+    test::check(sparseWeights.isApprox(geometric, 1e-8), "LLSM on a complete graph equals the geometric mean");
+
+    Eigen::VectorXd weights(4), products(4);
+    AHP::lambdaMax(matrix, AHP::PriorityMethod::GeometricMean, weights, products);
+    test::check(weights.isApprox(geometric, 1e-12), "geometric mean method");
+  }
+
+  // graphs without a pair to compare have nothing to solve
+  void logLeastSquaresTrivialGraphs() {
+    test::check(AHP::sparseLogLeastSquaresWeights(AHP::SparseComparisons{0, {}}).size() == 0, "LLSM of no items");
+    test::check(AHP::sparseLogLeastSquaresWeights(AHP::SparseComparisons{1, {}}).isApprox(Eigen::VectorXd::Ones(1)),
+                "LLSM of a single item");
+  }
+
+  // Two criteria of weight 0.5 over L = [0.8 0.3; 0.2 0.7]: R_0 = 0.3 + 0.5 c_0 and R_1 = 0.7 - 0.5 c_0, which tie
+  // at c_0 = 0.4, i.e. c_1 = 0.6
+  void sensitivityThresholds() {
+    Eigen::VectorXd criteria(2);
+    criteria << 0.5, 0.5;
+    AHP::Matrix2D local(2, 2);
+    local << 0.8, 0.3,
+             0.2, 0.7;
+    const auto sensitivity = AHP::criteriaSensitivity(criteria, local);
+
+    const auto& first = sensitivity[0];
+    test::checkNear(first.lower, 0.4, 1e-12, "lower bound of c_0");
+    test::checkNear(first.upper, 1.0, 1e-12, "upper bound of c_0");
+    test::checkNear(first.topLower, 0.4, 1e-12, "top lower bound of c_0");
+    test::checkNear(first.criticalDelta, -0.1, 1e-12, "critical delta of c_0");
+    test::check(first.criticalFirst == 0 && first.criticalSecond == 1, "critical pair of c_0");
+    test::checkNear(first.overtake(1), -0.1, 1e-12, "overtaking change of c_0");
+
+    const auto& second = sensitivity[1];
+    test::checkNear(second.lower, 0.0, 1e-12, "lower bound of c_1");
+    test::checkNear(second.upper, 0.6, 1e-12, "upper bound of c_1");
+    test::checkNear(second.criticalDelta, 0.1, 1e-12, "critical delta of c_1");
+  }
+
+  // Spread 1: the judgement 3 becomes (2, 3, 4) and 1 becomes (1/2, 1, 2). Row geometric means of the criteria are
+  // (sqrt 2, sqrt 3, 2) and (1/2, 1/sqrt 3, 1/sqrt 2), those of the indifferent alternatives (1/sqrt 2, 1, sqrt 2).
+  void fuzzyBounds() {
+    AHP::FuzzyMeanCalculator fuzzy(2, 2, 1.0);
+    AHP::Matrix2D critMatrix(2, 2);
+    critMatrix << 1.0, 3.0,
+                  1.0 / 3, 1.0;
+    const std::vector<AHP::Matrix2D> altMatrices(2, AHP::Matrix2D::Ones(2, 2));
+    fuzzy.addAgent(critMatrix, altMatrices);
+    const AHP::FuzzyResult result = fuzzy.rank();
+
+    const double s2 = std::sqrt(2.0), s3 = std::sqrt(3.0);
+    test::checkNear(result.criteria.lower(0), s2 / (2.0 + 1.0 / s2), 1e-12, "lower criterion weight");
+    test::checkNear(result.criteria.modal(0), s3 / (s3 + 1.0 / s3), 1e-12, "modal criterion weight");
+    test::checkNear(result.criteria.upper(0), 2.0 / (s2 + 0.5), 1e-12, "upper criterion weight");
+    test::checkNear(result.criteria.lower(1), 0.5 / (2.0 + 1.0 / s2), 1e-12, "lower weight of the second criterion");
+    test::checkNear(result.criteria.upper(1), (1.0 / s2) / (s2 + 0.5), 1e-12, "upper weight of the second criterion");
+    for (Eigen::Index a = 0; a < 2; a++) {
+      // local weights (1/4, 1/2, 1) under criteria weights summing to the bounds' sums
+      test::checkNear(result.ranking.lower(a), 0.25 * result.criteria.lower.sum(), 1e-12, "lower score");
+      test::checkNear(result.ranking.modal(a), 0.5, 1e-12, "modal score");
+      test::checkNear(result.ranking.upper(a), result.criteria.upper.sum(), 1e-12, "upper score");
+      test::checkNear(result.defuzzified(a), 0.5, 1e-12, "defuzzified score");
+    }
+  }
+
+  // Judgements off Saaty's scale are refused before the calculator changes, rounded reciprocals such as 0.111 are not
+  void fuzzyScaleRange() {
+    AHP::FuzzyMeanCalculator fuzzy(2, 2, 1.0);
+    const std::vector<AHP::Matrix2D> altMatrices(2, AHP::Matrix2D::Ones(2, 2));
+    for (double value : {12.0, 1.0 / 12, 0.0, -3.0, std::nan("")}) {
+      AHP::Matrix2D critMatrix(2, 2);
+      critMatrix << 1.0, value,
+                    1.0 / value, 1.0;
+      bool rejected = false;
+      try {
+        fuzzy.addAgent(critMatrix, altMatrices);
+      } catch (const std::invalid_argument&) {
+        rejected = true;
+      }
+      test::check(rejected, fmt::format("fuzzy judgement {} is rejected", value));
+
+      std::vector<AHP::Matrix2D> offScale = altMatrices;
+      offScale[1](0, 1) = value;
+      offScale[1](1, 0) = 1.0 / value;
+      rejected = false;
+      try {
+        fuzzy.addAgent(AHP::Matrix2D::Ones(2, 2), offScale);
+      } catch (const std::invalid_argument&) {
+        rejected = true;
+      }
+      test::check(rejected, fmt::format("fuzzy alternative judgement {} is rejected", value));
+    }
+
+    AHP::Matrix2D critMatrix(2, 2);
+    critMatrix << 1.0, 0.111,
+                  9.009, 1.0;
+    test::check(fuzzy.addAgent(critMatrix, altMatrices) == 0, "rounded 1/9 is accepted as the first agent");
+  }
+
+  AHP::SparseSupermatrix supermatrix(const AHP::Matrix2D& dense) {
+    return dense.sparseView();
+  }
+
+  // W = [0.5 0.25; 0.5 0.75] has the stationary vector (1/3, 2/3). Node 0 feeding nodes 1 and 2 (1/4, 3/4) and both
+  // feeding node 0 back alternates between (2/3, 1/12, 1/4) and (1/3, 1/6, 1/2), whose mean (1/2, 1/8, 3/8) is the limit.
+  void anpLimit() {
+    AHP::Matrix2D regular(2, 2);
+    regular << 0.5, 0.25,
+               0.5, 0.75;
+    const AHP::LimitPriorities limit = AHP::limitPriorities(supermatrix(regular));
+    test::check(limit.period == 1, "regular supermatrix converges");
+    test::checkNear(limit.priorities(0), 1.0 / 3, 1e-9, "limit priority of node 0");
+    test::checkNear(limit.priorities(1), 2.0 / 3, 1e-9, "limit priority of node 1");
+
+    AHP::Matrix2D cyclic(3, 3);
+    cyclic << 0.0,  1.0, 1.0,
+              0.25, 0.0, 0.0,
+              0.75, 0.0, 0.0;
+    const AHP::LimitPriorities cesaro = AHP::limitPriorities(supermatrix(cyclic));
+    test::check(cesaro.period == 2, "bipartite supermatrix cycles with period 2");
+    Eigen::VectorXd expected(3);
+    expected << 0.5, 0.125, 0.375;
+    test::check(cesaro.priorities.isApprox(expected, 1e-9), "Cesaro limit of the cycle");
+  }
+
+  // A path of n nodes has algebraic connectivity 2 (1 - cos(pi / n)) and a Fiedler vector monotone along it, so the
+  // widest unjudged pair joins its ends
+  void questionSelectorPath() {
+    const Eigen::Index n = 5;
+    AHP::QuestionSelector selector(n);
+    for (Eigen::Index i = 0; i + 1 < n; i++) {
+      selector.addJudgement(i, i + 1);
+    }
+    const auto pair = selector.next();
+    test::checkNear(selector.algebraicConnectivity(), 2.0 * (1.0 - std::cos(M_PI / n)), 1e-9,
+                    "algebraic connectivity of a path");
+    test::check(pair && pair->first == 0 && pair->second == n - 1, "a path is closed between its ends");
+  }
+}
+
+int main() {
+  consistentMatrixWeights();
+  logLeastSquaresOnFullGraph();
+  logLeastSquaresTrivialGraphs();
+  sensitivityThresholds();
+  fuzzyBounds();
+  fuzzyScaleRange();
+  anpLimit();
+  questionSelectorPath();
+  return test::failures;
+}
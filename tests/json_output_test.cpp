@@ -0,0 +1,45 @@
+#include "test_utils.h"
+#include "json_handling.h"
+
+#include <json.h>
+
+#include <cmath>
+#include <limits>
+
+// Names from a submitted setup must come back out of a response as the same JSON strings, and numbers no JSON
+// parser accepts must render as null
+namespace
+{
+  void quotedNames() {
+    const std::string setup = R"({ "alternatives": ["plain", "the \"best\" one", "back\\slash"], "criteria": ["tab\there"] })";
+    const json_handling::SetupData data = json_handling::parseSetup(setup);
+    test::check(data.alternatives.size() == 3 && data.alternatives[1] == "the \"best\" one", "setup keeps the quoted name");
+
+    // rendered the way the handlers do, then read back
+    std::string body = "{ \"names\": [";
+    for (size_t i = 0; i < data.alternatives.size(); i++) {
+      body += (i ? ", " : "") + json_handling::quote(data.alternatives[i]);
+    }
+    body += "], \"criterion\": " + json_handling::quote(data.criteria[0]) + " }";
+    json::jobject parsed = json::jobject::parse(body.c_str());
+    const std::vector<std::string> names = parsed["names"].as_array();
+    test::check(names == data.alternatives, "quoted names round-trip: " + body);
+    test::check(parsed["criterion"].as_string() == data.criteria[0], "control characters round-trip: " + body);
+
+    test::check(json_handling::quote("a\"b") == "\"a\\\"b\"", "quote escapes quotes");
+    test::check(json_handling::quote(std::string(1, '\x01')) == "\"\\u0001\"", "quote escapes control characters");
+  }
+
+  void nonFiniteNumbers() {
+    test::check(json_handling::number(0.25) == "0.25", "finite numbers");
+    test::check(json_handling::number(std::numeric_limits<double>::quiet_NaN()) == "null", "NaN renders as null");
+    test::check(json_handling::number(std::numeric_limits<double>::infinity()) == "null", "infinity renders as null");
+    test::check(json_handling::number(-std::numeric_limits<double>::infinity()) == "null", "-infinity renders as null");
+  }
+}
+
+int main() {
+  quotedNames();
+  nonFiniteNumbers();
+  return test::failures;
+}
@@ -0,0 +1,60 @@
+#include "test_utils.h"
+#include "parallel.h"
+
+#include <atomic>
+#include <fmt/format.h>
+#include <thread>
+#include <vector>
+
+// Loops nested in a parallelFor body run inline on whichever thread drains the outer index, the caller included,
+// rather than scheduling helpers onto a pool the outer loop keeps busy. Run with AHP_THREADS > 1.
+namespace
+{
+  constexpr Eigen::Index kOuter = 8;
+  constexpr Eigen::Index kInner = 16;
+
+  void nestedLoopsRunInline() {
+    std::vector<int> values(kOuter * kInner, -1);
+    std::vector<char> marked(kOuter, 0), inlined(kOuter, 1);
+    std::atomic<bool> callerJoined{false};
+
+    // the pool has fewer threads than outer indices, so holding each worker until the caller has claimed an index
+    // guarantees the caller takes part however the threads are scheduled
+    parallel::parallelFor(kOuter, parallel::kMinParallelCells, [&](Eigen::Index i) {
+      if (parallel::workerIndex() == 0) {
+        callerJoined.store(true);
+      }
+      while (!callerJoined.load()) {
+        std::this_thread::yield();
+      }
+
+      marked[i] = parallel::detail::insideLoop();
+      const auto outerThread = std::this_thread::get_id();
+      parallel::parallelFor(kInner, parallel::kMinParallelCells, [&](Eigen::Index j) {
+        values[i * kInner + j] = static_cast<int>(i * kInner + j);
+        if (std::this_thread::get_id() != outerThread) {
+          inlined[i] = 0;
+        }
+        std::this_thread::yield();
+      });
+    });
+
+    for (Eigen::Index i = 0; i < kOuter; i++) {
+      test::check(marked[i] == 1, fmt::format("outer index {} ran marked as inside a loop", i));
+      test::check(inlined[i] == 1, fmt::format("inner loop of outer index {} ran inline", i));
+      for (Eigen::Index j = 0; j < kInner; j++) {
+        test::check(values[i * kInner + j] == i * kInner + j, fmt::format("inner index {} of outer index {} ran", j, i));
+      }
+    }
+    test::check(!parallel::detail::insideLoop(), "the caller is not marked inside a loop afterwards");
+  }
+}
+
+int main() {
+  if (parallel::threadCount() < 2) {
+    std::cerr << "FAILED: needs AHP_THREADS > 1, got " << parallel::threadCount() << " thread\n";
+    return 1;
+  }
+  nestedLoopsRunInline();
+  return test::failures;
+}
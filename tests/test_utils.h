@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// Minimal checks shared by the test executables: a failed check is reported and counted, main returns the count
+namespace test
+{
+  inline int failures = 0;
+
+  inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+      std::cerr << "FAILED: " << what << "\n";
+      failures++;
+    }
+  }
+
+  inline void checkNear(double actual, double expected, double tolerance, const std::string& what) {
+    if (!(std::abs(actual - expected) <= tolerance)) {
+      std::cerr << "FAILED: " << what << ": " << actual << " != " << expected << " (tolerance " << tolerance << ")\n";
+      failures++;
+    }
+  }
+}
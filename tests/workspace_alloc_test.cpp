@@ -0,0 +1,67 @@
+#include "alloc_counter.h"
+#include "test_utils.h"
+#include "AHP.h"
+
+#include <fmt/format.h>
+#include <random>
+
+// Steady-state ranking with a reused RankingWorkspace must not touch the heap, for every priority method and for
+// shapes on both sides of the fixed-size kernels
+namespace
+{
+  AHP::Matrix2D randomReciprocalMatrix(Eigen::Index n, std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> scale(1, 9);
+    std::bernoulli_distribution invert(0.5);
+    AHP::Matrix2D matrix = AHP::Matrix2D::Ones(n, n);
+    for (Eigen::Index i = 0; i < n; i++) {
+      for (Eigen::Index j = i + 1; j < n; j++) {
+        const double value = scale(rng);
+        matrix(i, j) = invert(rng) ? 1.0 / value : value;
+        matrix(j, i) = 1.0 / matrix(i, j);
+      }
+    }
+    return matrix;
+  }
+
+  const double* volatile escaped;   // keeps the compiler from eliding the temporary below
+
+  // The counter must see Eigen's dynamic storage, or the checks below could not fail
+  void counterSeesEigenTemporaries() {
+    const auto before = bench::allocationCount();
+    Eigen::VectorXd temporary = Eigen::VectorXd::LinSpaced(100, 0.0, 1.0);
+    escaped = temporary.data();
+    test::check(bench::allocationCount() - before >= 1, "a VectorXd temporary is counted");
+  }
+}
+
+int main() {
+  counterSeesEigenTemporaries();
+
+  std::mt19937_64 rng(7);
+  const std::pair<Eigen::Index, Eigen::Index> shapes[] = {{3, 4}, {5, 10}, {9, 9}, {20, 50}};
+  const AHP::PriorityMethod methods[] = {AHP::PriorityMethod::GeometricMean, AHP::PriorityMethod::Eigenvector,
+                                         AHP::PriorityMethod::ColumnAverage, AHP::PriorityMethod::LogLeastSquares};
+
+  for (auto [criteria, alternatives] : shapes) {
+    const AHP::Matrix2D critMatrix = randomReciprocalMatrix(criteria, rng);
+    std::vector<AHP::Matrix2D> altMatrices;
+    for (Eigen::Index c = 0; c < criteria; c++) {
+      altMatrices.push_back(randomReciprocalMatrix(alternatives, rng));
+    }
+
+    for (size_t m = 0; m < std::size(methods); m++) {
+      AHP::AHPRanker ranker(methods[m]);
+      AHP::RankingWorkspace ws;
+      ranker.calculateRanking(critMatrix, altMatrices, ws);   // sizes the workspace
+
+      const auto before = bench::allocationCount();
+      for (int repeat = 0; repeat < 10; repeat++) {
+        ranker.calculateRanking(critMatrix, altMatrices, ws);
+      }
+      const auto allocations = bench::allocationCount() - before;
+      test::check(allocations == 0, fmt::format("{} allocations ranking {}x{} with method {}", allocations, criteria,
+                                                alternatives, m));
+    }
+  }
+  return test::failures;
+}